@@ -0,0 +1,212 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Versatile.h"
+#include "VersatileCharacter.h"
+#include "VersatilePlayerController.h"
+#include "Misc/AutomationTest.h"
+#include "Tests/AutomationCommon.h"
+#include "Engine.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/** Map opened when no game is running; its default pawn is a Versatile character */
+static const TCHAR* CameraCycleTestMap = TEXT("/Game/Maps/ThirdPersonExampleMap");
+
+/** Camera mode switches per pass, and frames between them; the frames between let the next mode be prepared */
+static const int32 CameraCycleTestSwitches = 40;
+static const int32 CameraCycleTestFramesPerSwitch = 3;
+
+/**
+ * Switch hitch, in milliseconds over the average frame, below which the pass without prewarm is treated
+ * as having nothing to remove. Above it, prewarm must at least halve the hitch.
+ */
+static const float CameraCycleTestMinMeasurableHitchMs = 2.f;
+
+/** Finds the running game or PIE world, which this test needs a local Versatile player in */
+static UWorld* FindCameraCycleTestWorld()
+{
+	for (const FWorldContext& Context : GEngine->GetWorldContexts())
+	{
+		if ((Context.WorldType == EWorldType::Game || Context.WorldType == EWorldType::PIE) && Context.World() != nullptr)
+		{
+			return Context.World();
+		}
+	}
+	return nullptr;
+}
+
+/** Returns the first local Versatile player controlling a Versatile character, if there is one */
+static AVersatilePlayerController* FindCameraCycleTestController()
+{
+	UWorld* World = FindCameraCycleTestWorld();
+	AVersatilePlayerController* PlayerController = World ? Cast<AVersatilePlayerController>(GEngine->GetFirstLocalPlayerController(World)) : nullptr;
+	return (PlayerController != nullptr && Cast<AVersatileCharacter>(PlayerController->GetPawn()) != nullptr) ? PlayerController : nullptr;
+}
+
+/** Frame times from one benchmark pass, shared between the latent commands of a run */
+struct FVersatileCameraCycleResults
+{
+	bool bMeasured;
+	float WorstFrameMs;
+	float WorstSwitchFrameMs;
+	float AverageFrameMs;
+	
+	FVersatileCameraCycleResults()
+		: bMeasured(false)
+		, WorstFrameMs(0.f)
+		, WorstSwitchFrameMs(0.f)
+		, AverageFrameMs(0.f)
+	{
+	}
+	
+	/** How much longer than an average frame the worst switch frame took */
+	float GetSwitchHitchMs() const { return WorstSwitchFrameMs - AverageFrameMs; }
+};
+
+DEFINE_LATENT_AUTOMATION_COMMAND_ONE_PARAMETER(FVersatileSetCameraPrewarmCommand, int32, Value);
+
+bool FVersatileSetCameraPrewarmCommand::Update()
+{
+	IConsoleVariable* CameraPrewarm = IConsoleManager::Get().FindConsoleVariable(TEXT("versatile.CameraPrewarm"));
+	if (CameraPrewarm != nullptr)
+	{
+		CameraPrewarm->Set(Value);
+	}
+	return true;
+}
+
+/** Runs VersatileCameraCycleBenchmark on the local player's controller and records its frame times */
+class FVersatileCameraCycleCommand : public IAutomationLatentCommand
+{
+public:
+	FVersatileCameraCycleCommand(FAutomationTestBase* InTest, bool bInPrewarm, TSharedRef<FVersatileCameraCycleResults> InResults)
+		: Test(InTest)
+		, bPrewarm(bInPrewarm)
+		, Results(InResults)
+		, bStarted(false)
+		, bPrepared(false)
+	{
+	}
+	
+	virtual bool Update() override
+	{
+		if (!Controller.IsValid())
+		{
+			// The map may have been opened by this test, so the player is only looked up once it has loaded
+			Controller = FindCameraCycleTestController();
+			if (!Controller.IsValid())
+			{
+				Test->AddWarning(FString::Printf(TEXT("Skipped: no local Versatile player is controlling a Versatile character. Run in a game or PIE session of %s"), CameraCycleTestMap));
+				return true;
+			}
+		}
+		
+		AVersatilePlayerController* PlayerController = Controller.Get();
+		AVersatileCharacter* Character = Cast<AVersatileCharacter>(PlayerController->GetPawn());
+		if (Character == nullptr)
+		{
+			Test->AddError(TEXT("The local player lost its Versatile pawn during camera cycling"));
+			return true;
+		}
+		
+		// With prewarm on, the first switch is prepared the way game code would on intent
+		if (bPrewarm && !bPrepared)
+		{
+			Character->PrewarmCameraMode(Character->GetNextCameraMode());
+			bPrepared = true;
+			return false;
+		}
+		
+		if (!bStarted)
+		{
+			PlayerController->VersatileCameraCycleBenchmark(CameraCycleTestSwitches, CameraCycleTestFramesPerSwitch);
+			bStarted = true;
+			return false;
+		}
+		
+		if (PlayerController->IsCameraCycleBenchmarkRunning()) return false;
+		
+		Results->bMeasured = true;
+		Results->WorstFrameMs = PlayerController->GetCameraCycleWorstFrameMs();
+		Results->WorstSwitchFrameMs = PlayerController->GetCameraCycleWorstSwitchFrameMs();
+		Results->AverageFrameMs = PlayerController->GetCameraCycleAverageFrameMs();
+		Test->AddInfo(FString::Printf(TEXT("Prewarm %s: worst frame %.2f ms, worst switch frame %.2f ms, avg %.2f ms"),
+			bPrewarm ? TEXT("on") : TEXT("off"), Results->WorstFrameMs, Results->WorstSwitchFrameMs, Results->AverageFrameMs));
+		return true;
+	}
+	
+private:
+	FAutomationTestBase* Test;
+	bool bPrewarm;
+	TSharedRef<FVersatileCameraCycleResults> Results;
+	TWeakObjectPtr<AVersatilePlayerController> Controller;
+	bool bStarted;
+	bool bPrepared;
+};
+
+/** Checks that prewarming removed most of the switch hitch the pass without it measured */
+class FVersatileCompareCameraCycleCommand : public IAutomationLatentCommand
+{
+public:
+	FVersatileCompareCameraCycleCommand(FAutomationTestBase* InTest, TSharedRef<FVersatileCameraCycleResults> InCold, TSharedRef<FVersatileCameraCycleResults> InPrewarmed)
+		: Test(InTest)
+		, Cold(InCold)
+		, Prewarmed(InPrewarmed)
+	{
+	}
+	
+	virtual bool Update() override
+	{
+		if (!Cold->bMeasured || !Prewarmed->bMeasured) return true;
+		
+		const float ColdHitchMs = Cold->GetSwitchHitchMs();
+		const float PrewarmedHitchMs = Prewarmed->GetSwitchHitchMs();
+		if (ColdHitchMs < CameraCycleTestMinMeasurableHitchMs)
+		{
+			Test->AddWarning(FString::Printf(TEXT("Switching without prewarm only took %.2f ms over the average frame, too little to compare"), ColdHitchMs));
+		}
+		else if (PrewarmedHitchMs > ColdHitchMs * .5f)
+		{
+			Test->AddError(FString::Printf(TEXT("Prewarm left a %.2f ms switch hitch, more than half of the %.2f ms without it"), PrewarmedHitchMs, ColdHitchMs));
+		}
+		return true;
+	}
+	
+private:
+	FAutomationTestBase* Test;
+	TSharedRef<FVersatileCameraCycleResults> Cold;
+	TSharedRef<FVersatileCameraCycleResults> Prewarmed;
+};
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FVersatileCameraCycleTest, "Versatile.Camera.RapidCycleWorstFrame", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+/**
+ * Cycles the local player's camera mode rapidly with versatile.CameraPrewarm off and then on, records the
+ * worst frame time of each pass and checks that prewarming removes most of the switch hitch.
+ * Opens ThirdPersonExampleMap when no game is running; where that gives no local player, e.g. in the
+ * editor outside PIE, the test is skipped with a warning.
+ */
+bool FVersatileCameraCycleTest::RunTest(const FString& Parameters)
+{
+	if (FindCameraCycleTestController() == nullptr)
+	{
+		AutomationOpenMap(CameraCycleTestMap);
+		ADD_LATENT_AUTOMATION_COMMAND(FWaitForMapToLoadCommand());
+	}
+	
+	IConsoleVariable* CameraPrewarm = IConsoleManager::Get().FindConsoleVariable(TEXT("versatile.CameraPrewarm"));
+	const int32 OriginalCameraPrewarm = CameraPrewarm ? CameraPrewarm->GetInt() : 1;
+	
+	TSharedRef<FVersatileCameraCycleResults> Cold = MakeShareable(new FVersatileCameraCycleResults());
+	TSharedRef<FVersatileCameraCycleResults> Prewarmed = MakeShareable(new FVersatileCameraCycleResults());
+	
+	ADD_LATENT_AUTOMATION_COMMAND(FVersatileSetCameraPrewarmCommand(0));
+	ADD_LATENT_AUTOMATION_COMMAND(FVersatileCameraCycleCommand(this, false, Cold));
+	ADD_LATENT_AUTOMATION_COMMAND(FVersatileSetCameraPrewarmCommand(1));
+	ADD_LATENT_AUTOMATION_COMMAND(FVersatileCameraCycleCommand(this, true, Prewarmed));
+	ADD_LATENT_AUTOMATION_COMMAND(FVersatileSetCameraPrewarmCommand(OriginalCameraPrewarm));
+	ADD_LATENT_AUTOMATION_COMMAND(FVersatileCompareCameraCycleCommand(this, Cold, Prewarmed));
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
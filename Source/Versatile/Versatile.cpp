@@ -3,5 +3,7 @@
 #include "Versatile.h"
 
 
+DEFINE_LOG_CATEGORY(LogVersatile);
+
 IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, Versatile, "Versatile" );
  
\ No newline at end of file
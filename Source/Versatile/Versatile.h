@@ -5,4 +5,8 @@
 
 #include "EngineMinimal.h"
 
+DECLARE_LOG_CATEGORY_EXTERN(LogVersatile, Log, All);
+
+DECLARE_STATS_GROUP(TEXT("Versatile"), STATGROUP_Versatile, STATCAT_Advanced);
+
 #endif
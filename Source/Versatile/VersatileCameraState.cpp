@@ -0,0 +1,104 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Versatile.h"
+#include "VersatileCameraState.h"
+#include "VersatileCharacter.h"
+#include "Serialization/MemoryWriter.h"
+#include "Serialization/MemoryReader.h"
+
+FVersatileCameraState::FVersatileCameraState()
+	: CameraMode(ECharacterCameraMode::ThirdPersonDefault)
+	, CameraZoomCurrent(300.f)
+	, CameraFollowTurnAngleExponent(.25f)
+	, CameraFollowTurnRate(.3f)
+	, CameraResetSpeed(1.f)
+	, AutoResetDelaySeconds(2.5f)
+	, AutoResetSpeed(.15f)
+	, bAutoResetSmoothFollowCameraWhenIdle(true)
+{
+}
+
+int32 FVersatileCameraState::GetRecordSize(uint8 Version)
+{
+	switch (Version)
+	{
+		case 1:
+			return RecordSizeV1;
+		default:
+			return 0;
+	}
+}
+
+FArchive& operator<<(FArchive& Ar, FVersatileCameraState& State)
+{
+	// Layout (little endian):
+	//  0  uint16	Magic
+	//  2  uint8	Version
+	//  3  uint8	CameraMode
+	//  4  float	CameraZoomCurrent
+	//  8  float	CameraFollowTurnAngleExponent
+	// 12  float	CameraFollowTurnRate
+	// 16  float	CameraResetSpeed
+	// 20  float	AutoResetDelaySeconds
+	// 24  float	AutoResetSpeed
+	// 28  uint8	Flags (bit 0: bAutoResetSmoothFollowCameraWhenIdle)
+	// 29  uint8[3]	Reserved
+	uint16 Magic = FVersatileCameraState::Magic;
+	uint8 Version = FVersatileCameraState::CurrentVersion;
+	Ar << Magic;
+	Ar << Version;
+	
+	if (Ar.IsLoading() && (Magic != FVersatileCameraState::Magic || FVersatileCameraState::GetRecordSize(Version) == 0))
+	{
+		Ar.SetError();
+		return Ar;
+	}
+	
+	uint8 Flags = State.bAutoResetSmoothFollowCameraWhenIdle ? 1 : 0;
+	uint8 Reserved[3] = { 0, 0, 0 };
+	
+	Ar << State.CameraMode;
+	Ar << State.CameraZoomCurrent;
+	Ar << State.CameraFollowTurnAngleExponent;
+	Ar << State.CameraFollowTurnRate;
+	Ar << State.CameraResetSpeed;
+	Ar << State.AutoResetDelaySeconds;
+	Ar << State.AutoResetSpeed;
+	Ar << Flags;
+	Ar.Serialize(Reserved, sizeof(Reserved));
+	
+	// Fields from later versions go here, each read only when Version is new enough to have it,
+	// e.g. if (Version >= 2) { Ar << State.NewField; }
+	
+	if (Ar.IsLoading())
+	{
+		State.bAutoResetSmoothFollowCameraWhenIdle = (Flags & 1) != 0;
+	}
+	return Ar;
+}
+
+void FVersatileCameraState::ToBytes(TArray<uint8>& OutBytes) const
+{
+	OutBytes.Reset(RecordSize);
+	FMemoryWriter Writer(OutBytes);
+	Writer << const_cast<FVersatileCameraState&>(*this);
+	check(OutBytes.Num() == RecordSize);
+}
+
+bool FVersatileCameraState::FromBytes(const TArray<uint8>& Bytes)
+{
+	// The version after the magic number decides how long the record must be
+	const int32 HeaderSize = sizeof(uint16) + sizeof(uint8);
+	if (Bytes.Num() < HeaderSize) return false;
+	
+	const int32 ExpectedSize = GetRecordSize(Bytes[HeaderSize - 1]);
+	if (ExpectedSize == 0 || Bytes.Num() < ExpectedSize) return false;
+	
+	FVersatileCameraState Loaded;
+	FMemoryReader Reader(Bytes);
+	Reader << Loaded;
+	if (Reader.IsError() || Loaded.CameraMode >= ECharacterCameraMode::Max) return false;
+	
+	*this = Loaded;
+	return true;
+}
@@ -0,0 +1,101 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "GameFramework/SaveGame.h"
+#include "VersatileCameraState.generated.h"
+
+class AVersatileCharacter;
+
+// MARK: - FVersatileCameraState
+
+/**
+ * A player's camera mode, zoom and follow tuning as a versioned, fixed-layout binary record.
+ * Fields are written in a fixed order with no reflection, so storing or restoring one costs about
+ * as much as a memcpy. To add a field, bump CurrentVersion, append it after the existing fields and
+ * read it only from records of that version or later, then add a RecordSizeV<N> for the new size and
+ * point RecordSize and GetRecordSize at it. Older records then still load, with defaults for the fields
+ * they predate.
+ */
+struct VERSATILE_API FVersatileCameraState
+{
+	/** Identifies a camera state record */
+	static const uint16 Magic = 0x5643;
+	
+	/** Version written by this build */
+	static const uint8 CurrentVersion = 1;
+	
+	/** Size in bytes of each record version */
+	static const int32 RecordSizeV1 = 32;
+	
+	/** Size in bytes of a record written by this build, the size of CurrentVersion */
+	static const int32 RecordSize = RecordSizeV1;
+	
+	/** Size in bytes of a record of the given version, or 0 for versions this build cannot read */
+	static int32 GetRecordSize(uint8 Version);
+	
+	uint8 CameraMode;
+	float CameraZoomCurrent;
+	float CameraFollowTurnAngleExponent;
+	float CameraFollowTurnRate;
+	float CameraResetSpeed;
+	float AutoResetDelaySeconds;
+	float AutoResetSpeed;
+	bool bAutoResetSmoothFollowCameraWhenIdle;
+	
+	FVersatileCameraState();
+	
+	/**
+	 * Writes the record into a byte array, replacing its contents.
+	 * @param OutBytes	Receives exactly RecordSize bytes
+	 */
+	void ToBytes(TArray<uint8>& OutBytes) const;
+	
+	/**
+	 * Reads a record written by ToBytes.
+	 * Records from older versions load with defaults for the fields they do not have.
+	 * @param Bytes	The record
+	 * @return Whether the bytes held a record this build understands; the state is unchanged if not
+	 */
+	bool FromBytes(const TArray<uint8>& Bytes);
+	
+	friend VERSATILE_API FArchive& operator<<(FArchive& Ar, FVersatileCameraState& State);
+};
+
+// MARK: - UVersatileCameraSaveGame
+
+/**
+ * The same camera state as a save game object, serialized through property reflection.
+ * Only used as the baseline when benchmarking FVersatileCameraState.
+ */
+UCLASS()
+class VERSATILE_API UVersatileCameraSaveGame : public USaveGame
+{
+	GENERATED_BODY()
+	
+public:
+	UPROPERTY()
+	uint8 CameraMode;
+	
+	UPROPERTY()
+	float CameraZoomCurrent;
+	
+	UPROPERTY()
+	float CameraFollowTurnAngleExponent;
+	
+	UPROPERTY()
+	float CameraFollowTurnRate;
+	
+	UPROPERTY()
+	float CameraResetSpeed;
+	
+	UPROPERTY()
+	float AutoResetDelaySeconds;
+	
+	UPROPERTY()
+	float AutoResetSpeed;
+	
+	UPROPERTY()
+	bool bAutoResetSmoothFollowCameraWhenIdle;
+	
+};
@@ -0,0 +1,179 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Versatile.h"
+#include "VersatileCameraTelemetry.h"
+#include "Async/AsyncWork.h"
+#include "Serialization/MemoryWriter.h"
+
+DECLARE_CYCLE_STAT(TEXT("Camera Telemetry"), STAT_VersatileCameraTelemetry, STATGROUP_Versatile);
+DECLARE_CYCLE_STAT(TEXT("Camera Telemetry Flush"), STAT_VersatileCameraTelemetryFlush, STATGROUP_Versatile);
+
+static TAutoConsoleVariable<int32> CVarVersatileCameraTelemetry(
+	TEXT("versatile.CameraTelemetry"),
+	1,
+	TEXT("Whether local players record camera behaviour histograms to Saved/VersatileCameraTelemetry*.bin."),
+	ECVF_Default);
+
+/** Serializes writes from every player's telemetry, so a flush never interleaves with another to the same file */
+static FCriticalSection CameraTelemetryFileLock;
+
+/** Appends serialized intervals to a telemetry file, moving a full file aside first */
+static void AppendCameraTelemetry(const FString& Filename, const TArray<uint8>& Bytes, int64 MaxFileBytes)
+{
+	FScopeLock Lock(&CameraTelemetryFileLock);
+	
+	IFileManager& FileManager = IFileManager::Get();
+	if (MaxFileBytes > 0 && FileManager.FileSize(*Filename) + Bytes.Num() > MaxFileBytes)
+	{
+		FileManager.Move(*(Filename + TEXT(".old")), *Filename, true);
+	}
+	
+	FArchive* Ar = FileManager.CreateFileWriter(*Filename, FILEWRITE_Append);
+	if (Ar == nullptr)
+	{
+		UE_LOG(LogVersatile, Warning, TEXT("Could not open %s for camera telemetry"), *Filename);
+		return;
+	}
+	Ar->Serialize(const_cast<uint8*>(Bytes.GetData()), Bytes.Num());
+	Ar->Close();
+	delete Ar;
+}
+
+/** Writes one flushed interval on a pool thread */
+class FVersatileCameraTelemetryWriteTask : public FNonAbandonableTask
+{
+	friend class FAutoDeleteAsyncTask<FVersatileCameraTelemetryWriteTask>;
+	
+	FString Filename;
+	TArray<uint8> Bytes;
+	int64 MaxFileBytes;
+	
+	FVersatileCameraTelemetryWriteTask(const FString& InFilename, TArray<uint8>&& InBytes, int64 InMaxFileBytes)
+		: Filename(InFilename)
+		, Bytes(MoveTemp(InBytes))
+		, MaxFileBytes(InMaxFileBytes)
+	{
+	}
+	
+	void DoWork()
+	{
+		AppendCameraTelemetry(Filename, Bytes, MaxFileBytes);
+	}
+	
+	FORCEINLINE TStatId GetStatId() const
+	{
+		RETURN_QUICK_DECLARE_CYCLE_STAT(FVersatileCameraTelemetryWriteTask, STATGROUP_ThreadPoolAsyncTasks);
+	}
+};
+
+FVersatileCameraTelemetry::FVersatileCameraTelemetry()
+	: FlushIntervalSeconds(60.f)
+	, MaxFileBytes(1024 * 1024)
+	, ResetDurations(0.f, 8.f)
+	, YawJitter(0.f, 8.f)
+	, ZoomDistances(0.f, 800.f)
+{
+	ResetInterval();
+}
+
+bool FVersatileCameraTelemetry::IsEnabled()
+{
+	return CVarVersatileCameraTelemetry.GetValueOnGameThread() != 0;
+}
+
+void FVersatileCameraTelemetry::RecordFrame(ECharacterCameraMode::Type CameraMode, float DeltaSeconds, float YawDelta, float ZoomDistance)
+{
+	SCOPE_CYCLE_COUNTER(STAT_VersatileCameraTelemetry);
+	
+	if (CameraMode < ECharacterCameraMode::Max)
+	{
+		ModeSeconds[CameraMode] += DeltaSeconds;
+	}
+	
+	// Jitter is how much the turn changes from one frame to the next, not the turn itself
+	YawJitter.Add(FMath::Abs(YawDelta - LastYawDelta));
+	LastYawDelta = YawDelta;
+	
+	if (IsThirdPerson(CameraMode))
+	{
+		ZoomDistances.Add(ZoomDistance);
+	}
+}
+
+void FVersatileCameraTelemetry::RecordReset(float DurationSeconds, bool bAutoReset)
+{
+	ResetDurations.Add(DurationSeconds);
+	ResetCount++;
+	if (bAutoReset)
+	{
+		AutoResetCount++;
+	}
+}
+
+bool FVersatileCameraTelemetry::Tick(float DeltaSeconds)
+{
+	IntervalSeconds += DeltaSeconds;
+	return IntervalSeconds >= FlushIntervalSeconds;
+}
+
+void FVersatileCameraTelemetry::Flush(const FString& Filename, bool bAsync)
+{
+	SCOPE_CYCLE_COUNTER(STAT_VersatileCameraTelemetryFlush);
+	
+	if (YawJitter.Total == 0 && ResetCount == 0)
+	{
+		ResetInterval();
+		return;
+	}
+	
+	// Interval record:
+	//  uint32		Magic
+	//  uint8		Version
+	//  int64		UTC ticks at flush
+	//  float		Interval seconds
+	//  uint8		Mode count, then float seconds per mode
+	//  uint32		Reset count, auto reset count
+	//  histogram	Reset durations, yaw jitter, zoom distances (float Min, float Max, uint8 N, uint32 Counts[N])
+	TArray<uint8> Bytes;
+	FMemoryWriter Ar(Bytes);
+	
+	uint32 OutMagic = Magic;
+	uint8 OutVersion = CurrentVersion;
+	int64 Timestamp = FDateTime::UtcNow().GetTicks();
+	uint8 ModeCount = ECharacterCameraMode::Max;
+	Ar << OutMagic << OutVersion << Timestamp << IntervalSeconds << ModeCount;
+	for (int32 Mode = 0; Mode < ECharacterCameraMode::Max; Mode++)
+	{
+		Ar << ModeSeconds[Mode];
+	}
+	Ar << ResetCount << AutoResetCount;
+	ResetDurations.Write(Ar);
+	YawJitter.Write(Ar);
+	ZoomDistances.Write(Ar);
+	
+	if (bAsync)
+	{
+		(new FAutoDeleteAsyncTask<FVersatileCameraTelemetryWriteTask>(Filename, MoveTemp(Bytes), MaxFileBytes))->StartBackgroundTask();
+	}
+	else
+	{
+		AppendCameraTelemetry(Filename, Bytes, MaxFileBytes);
+	}
+	
+	ResetInterval();
+}
+
+void FVersatileCameraTelemetry::ResetInterval()
+{
+	ResetDurations.Reset();
+	YawJitter.Reset();
+	ZoomDistances.Reset();
+	for (int32 Mode = 0; Mode < ECharacterCameraMode::Max; Mode++)
+	{
+		ModeSeconds[Mode] = 0.f;
+	}
+	ResetCount = 0;
+	AutoResetCount = 0;
+	LastYawDelta = 0.f;
+	IntervalSeconds = 0.f;
+}
@@ -0,0 +1,136 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "VersatileCharacter.h"
+
+// MARK: - TVersatileHistogram
+
+/**
+ * Fixed-bucket histogram over [Min, Max). Values outside the range land in the end buckets.
+ * Adding a value never allocates.
+ */
+template<int32 NumBuckets>
+struct TVersatileHistogram
+{
+	float Min;
+	float Max;
+	uint32 Counts[NumBuckets];
+	uint32 Total;
+	double Sum;
+	
+	TVersatileHistogram(float InMin, float InMax)
+		: Min(InMin)
+		, Max(InMax)
+	{
+		Reset();
+	}
+	
+	void Add(float Value)
+	{
+		const int32 Bucket = FMath::Clamp(FMath::FloorToInt((Value - Min) / (Max - Min) * NumBuckets), 0, NumBuckets - 1);
+		Counts[Bucket]++;
+		Total++;
+		Sum += Value;
+	}
+	
+	void Reset()
+	{
+		FMemory::Memzero(Counts, sizeof(Counts));
+		Total = 0;
+		Sum = 0.0;
+	}
+	
+	/** Writes Min, Max, bucket count and the counts */
+	void Write(FArchive& Ar) const
+	{
+		float OutMin = Min;
+		float OutMax = Max;
+		uint8 OutNumBuckets = NumBuckets;
+		Ar << OutMin << OutMax << OutNumBuckets;
+		for (int32 Bucket = 0; Bucket < NumBuckets; Bucket++)
+		{
+			uint32 Count = Counts[Bucket];
+			Ar << Count;
+		}
+	}
+};
+
+// MARK: - FVersatileCameraTelemetry
+
+/**
+ * Collects how a local player's follow and reset camera behaves: reset durations, auto reset frequency,
+ * frame-to-frame yaw jitter, zoom distance and time spent in each camera mode.
+ * Recording is a handful of bucket increments per frame (budget: under 1 microsecond per frame,
+ * tracked by the Camera Telemetry stat). Intervals are appended to a compact binary file by Flush.
+ * The flush frame only serializes the interval, a few hundred bytes, into memory (tracked by the
+ * Camera Telemetry Flush stat); the file is written on a pool thread.
+ */
+struct VERSATILE_API FVersatileCameraTelemetry
+{
+	/** Identifies a telemetry interval record */
+	static const uint32 Magic = 0x54435653;
+	
+	/** Version of the interval record written by this build */
+	static const uint8 CurrentVersion = 1;
+	
+	/** Seconds between writing intervals to disk */
+	float FlushIntervalSeconds;
+	
+	/**
+	 * Size a telemetry file may reach before it is moved to <Filename>.old, replacing any older one,
+	 * and a new file started. Telemetry therefore never takes more than twice this on disk. 0 for no limit
+	 */
+	int64 MaxFileBytes;
+	
+	FVersatileCameraTelemetry();
+	
+	/** Whether telemetry is being recorded at all (versatile.CameraTelemetry) */
+	static bool IsEnabled();
+	
+	/**
+	 * Records one camera frame.
+	 * @param CameraMode	The active camera mode
+	 * @param DeltaSeconds	Frame time
+	 * @param YawDelta		Change in control yaw this frame, in degrees
+	 * @param ZoomDistance	Current follow camera zoom distance
+	 */
+	void RecordFrame(ECharacterCameraMode::Type CameraMode, float DeltaSeconds, float YawDelta, float ZoomDistance);
+	
+	/**
+	 * Records a finished camera reset.
+	 * @param DurationSeconds	How long the reset took
+	 * @param bAutoReset		Whether it was started by the idle auto reset
+	 */
+	void RecordReset(float DurationSeconds, bool bAutoReset);
+	
+	/**
+	 * Advances the flush timer. The owner builds the filename and calls Flush only when this returns true,
+	 * so the per-frame path never allocates.
+	 * @param DeltaSeconds	Frame time
+	 * @return Whether the current interval is due to be flushed
+	 */
+	bool Tick(float DeltaSeconds);
+	
+	/**
+	 * Appends the current interval to Filename and starts a new one. Does nothing for an empty interval.
+	 * @param Filename	File to append to
+	 * @param bAsync	Whether to write the file on a pool thread rather than before returning
+	 */
+	void Flush(const FString& Filename, bool bAsync = true);
+	
+private:
+	TVersatileHistogram<16> ResetDurations;
+	TVersatileHistogram<16> YawJitter;
+	TVersatileHistogram<16> ZoomDistances;
+	float ModeSeconds[ECharacterCameraMode::Max];
+	uint32 ResetCount;
+	uint32 AutoResetCount;
+	
+	/** Previous frame's yaw change, for jitter */
+	float LastYawDelta;
+	
+	float IntervalSeconds;
+	
+	void ResetInterval();
+};
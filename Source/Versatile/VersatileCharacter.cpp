@@ -4,12 +4,123 @@
 #include "Versatile.h"
 #include "Kismet/HeadMountedDisplayFunctionLibrary.h"
 #include "VersatileCharacter.h"
+#include "VersatilePlayerController.h"
+#include "VersatileSignificanceManager.h"
+#include "VersatileCharacterMovementComponent.h"
 #include "Engine.h"
 
+static TAutoConsoleVariable<int32> CVarVersatileCameraPrewarm(
+	TEXT("versatile.CameraPrewarm"),
+	1,
+	TEXT("Whether locally controlled characters prepare the next camera mode ahead of CycleCamera.\n")
+	TEXT(" 0: each switch updates mesh visibility and render state\n")
+	TEXT(" 1: prepare the next mode a frame after each switch (default)"),
+	ECVF_Default);
+
+//////////////////////////////////////////////////////////////////////////
+// FVersatileCameraRig
+
+FVersatileCameraRig::FVersatileCameraRig()
+{
+	Reset();
+}
+
+bool FVersatileCameraRig::IsComplete() const
+{
+	return CameraBoom && FollowCamera && FirstPersonCamera && ArmsMesh && BodyMesh && OverShoulderCameraBoom && OverShoulderCamera;
+}
+
+/** Changes the outer (and so the owning actor) of a component, keeping its name where possible */
+static void MoveComponentToOwner(UActorComponent* Component, AActor* NewOwner)
+{
+	if (Component == nullptr || Component->GetOwner() == NewOwner) return;
+	
+	const FName NewName = MakeUniqueObjectName(NewOwner, Component->GetClass(), Component->GetFName());
+	Component->Rename(*NewName.ToString(), NewOwner, REN_DontCreateRedirectors | REN_ForceNoResetLoaders);
+}
+
+void FVersatileCameraRig::MoveTo(AActor* NewOwner, USceneComponent* AttachParent) const
+{
+	if (!IsComplete()) return;
+	
+	MoveComponentToOwner(CameraBoom, NewOwner);
+	MoveComponentToOwner(FollowCamera, NewOwner);
+	MoveComponentToOwner(FirstPersonCamera, NewOwner);
+	MoveComponentToOwner(ArmsMesh, NewOwner);
+	MoveComponentToOwner(BodyMesh, NewOwner);
+	MoveComponentToOwner(OverShoulderCameraBoom, NewOwner);
+	MoveComponentToOwner(OverShoulderCamera, NewOwner);
+	
+	// Only the roots of the rig change parent; cameras stay on their booms and the arms on their camera
+	USceneComponent* Roots[] = { CameraBoom, FirstPersonCamera, BodyMesh, OverShoulderCameraBoom };
+	for (USceneComponent* Root : Roots)
+	{
+		if (AttachParent != nullptr)
+		{
+			Root->AttachToComponent(AttachParent, FAttachmentTransformRules::KeepRelativeTransform);
+		}
+		else
+		{
+			Root->DetachFromComponent(FDetachmentTransformRules::KeepRelativeTransform);
+		}
+	}
+	
+	// Parked rigs stay registered but do no per-frame work
+	const bool bInUse = (AttachParent != nullptr);
+	CameraBoom->SetComponentTickEnabled(bInUse);
+	OverShoulderCameraBoom->SetComponentTickEnabled(bInUse);
+	ArmsMesh->SetComponentTickEnabled(bInUse);
+	BodyMesh->SetComponentTickEnabled(bInUse);
+	if (!bInUse)
+	{
+		FollowCamera->SetActive(false);
+		FirstPersonCamera->SetActive(false);
+		OverShoulderCamera->SetActive(false);
+		ArmsMesh->SetVisibility(false);
+		BodyMesh->SetVisibility(false);
+	}
+}
+
+void FVersatileCameraRig::DestroyComponents()
+{
+	// Children are destroyed before their parents
+	if (OverShoulderCamera) OverShoulderCamera->DestroyComponent();
+	if (OverShoulderCameraBoom) OverShoulderCameraBoom->DestroyComponent();
+	if (BodyMesh) BodyMesh->DestroyComponent();
+	if (ArmsMesh) ArmsMesh->DestroyComponent();
+	if (FirstPersonCamera) FirstPersonCamera->DestroyComponent();
+	if (FollowCamera) FollowCamera->DestroyComponent();
+	if (CameraBoom) CameraBoom->DestroyComponent();
+	
+	Reset();
+}
+
+void FVersatileCameraRig::Reset()
+{
+	CameraBoom = nullptr;
+	FollowCamera = nullptr;
+	FirstPersonCamera = nullptr;
+	ArmsMesh = nullptr;
+	BodyMesh = nullptr;
+	OverShoulderCameraBoom = nullptr;
+	OverShoulderCamera = nullptr;
+	CameraMode = ECharacterCameraMode::ThirdPersonDefault;
+	CameraZoomCurrent = 0.f;	TemplateClass = nullptr;
+}
+
 //////////////////////////////////////////////////////////////////////////
 // AVersatileCharacter
 
-AVersatileCharacter::AVersatileCharacter()
+FName AVersatileCharacter::ArmsMeshName(TEXT("CharacterMesh1P"));
+FName AVersatileCharacter::BodyMeshName(TEXT("CharacterBody1P"));
+FName AVersatileCharacter::CameraBoomName(TEXT("CameraBoom"));
+FName AVersatileCharacter::FollowCameraName(TEXT("FollowCamera"));
+FName AVersatileCharacter::FirstPersonCameraName(TEXT("FirstPersonCamera"));
+FName AVersatileCharacter::OverShoulderCameraBoomName(TEXT("ShoulderCameraBoom"));
+FName AVersatileCharacter::OverShoulderCameraName(TEXT("ShoulderCamera"));
+
+AVersatileCharacter::AVersatileCharacter(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer.SetDefaultSubobjectClass<UVersatileCharacterMovementComponent>(ACharacter::CharacterMovementComponentName))
 {
 	// Set size for collision capsule
 	GetCapsuleComponent()->InitCapsuleSize(42.f, 96.0f);
@@ -33,46 +144,70 @@ AVersatileCharacter::AVersatileCharacter()
 	MoveComp->RotationRate = FRotator(0.0f, 540.0f, 0.0f); // ...at this rotation rate
 	MoveComp->AirControl = 0.2f;
 
+	// Camera and first person components are optional so that lightweight variants can skip them
+	// with DoNotCreateDefaultSubobject and create them on demand when possessed by a local player.
+	
 	// Create a camera boom (pulls in towards the player if there is a collision)
-	CameraBoom = CreateDefaultSubobject<USpringArmComponent>(TEXT("CameraBoom"));
-	CameraBoom->SetupAttachment(GetCapsuleComponent());
-	CameraBoom->bUsePawnControlRotation = true; // Rotate the arm based on the controller
+	CameraBoom = CreateOptionalDefaultSubobject<USpringArmComponent>(CameraBoomName);
+	if (CameraBoom)
+	{
+		CameraBoom->SetupAttachment(GetCapsuleComponent());
+		CameraBoom->bUsePawnControlRotation = true; // Rotate the arm based on the controller
+	}
 
 	// Create a follow camera
-	FollowCamera = CreateDefaultSubobject<UCameraComponent>(TEXT("FollowCamera"));
-	FollowCamera->SetupAttachment(CameraBoom, USpringArmComponent::SocketName); // Attach the camera to the end of the boom and let the boom adjust to match the controller orientation
-	FollowCamera->bUsePawnControlRotation = false; // Camera does not rotate relative to arm
+	FollowCamera = CreateOptionalDefaultSubobject<UCameraComponent>(FollowCameraName);
+	if (FollowCamera)
+	{
+		FollowCamera->SetupAttachment(CameraBoom, USpringArmComponent::SocketName); // Attach the camera to the end of the boom and let the boom adjust to match the controller orientation
+		FollowCamera->bUsePawnControlRotation = false; // Camera does not rotate relative to arm
+	}
 	
 	// First person camera and arms
-	FirstPersonCamera = CreateDefaultSubobject<UCameraComponent>(TEXT("FirstPersonCamera"));
-	FirstPersonCamera->SetupAttachment(GetCapsuleComponent());
-	FirstPersonCamera->RelativeLocation = FVector(-39.56f, 1.75f, 64.f); // Position the camera
-	FirstPersonCamera->bUsePawnControlRotation = true;
+	FirstPersonCamera = CreateOptionalDefaultSubobject<UCameraComponent>(FirstPersonCameraName);
+	if (FirstPersonCamera)
+	{
+		FirstPersonCamera->SetupAttachment(GetCapsuleComponent());
+		FirstPersonCamera->RelativeLocation = FVector(-39.56f, 1.75f, 64.f); // Position the camera
+		FirstPersonCamera->bUsePawnControlRotation = true;
+	}
 	
-	ArmsMesh = CreateDefaultSubobject<USkeletalMeshComponent>(TEXT("CharacterMesh1P"));
-	ArmsMesh->SetOnlyOwnerSee(true);
-	ArmsMesh->SetupAttachment(FirstPersonCamera);
-	ArmsMesh->bCastDynamicShadow = false;
-	ArmsMesh->CastShadow = false;
-	ArmsMesh->RelativeRotation = FRotator(1.9f, -19.19f, 5.2f);
-	ArmsMesh->RelativeLocation = FVector(-0.5f, -4.4f, -155.7f);
+	ArmsMesh = CreateOptionalDefaultSubobject<USkeletalMeshComponent>(ArmsMeshName);
+	if (ArmsMesh)
+	{
+		ArmsMesh->SetOnlyOwnerSee(true);
+		ArmsMesh->SetupAttachment(FirstPersonCamera);
+		ArmsMesh->bCastDynamicShadow = false;
+		ArmsMesh->CastShadow = false;
+		ArmsMesh->RelativeRotation = FRotator(1.9f, -19.19f, 5.2f);
+		ArmsMesh->RelativeLocation = FVector(-0.5f, -4.4f, -155.7f);
+	}
 	
-	BodyMesh = CreateDefaultSubobject<USkeletalMeshComponent>(TEXT("CharacterBody1P"));
-	BodyMesh->SetOnlyOwnerSee(true);
-	BodyMesh->SetupAttachment(GetCapsuleComponent());
-	BodyMesh->bCastDynamicShadow = false;
-	BodyMesh->CastShadow = false;
+	BodyMesh = CreateOptionalDefaultSubobject<USkeletalMeshComponent>(BodyMeshName);
+	if (BodyMesh)
+	{
+		BodyMesh->SetOnlyOwnerSee(true);
+		BodyMesh->SetupAttachment(GetCapsuleComponent());
+		BodyMesh->bCastDynamicShadow = false;
+		BodyMesh->CastShadow = false;
+	}
 	
 	// Create a camera boom (pulls in towards the player if there is a collision)
-	OverShoulderCameraBoom = CreateDefaultSubobject<USpringArmComponent>(TEXT("ShoulderCameraBoom"));
-	OverShoulderCameraBoom->SetupAttachment(GetCapsuleComponent());
-	OverShoulderCameraBoom->bUsePawnControlRotation = false; // Fixed Camera
-	OverShoulderCameraBoom->TargetArmLength = 75.0f;
+	OverShoulderCameraBoom = CreateOptionalDefaultSubobject<USpringArmComponent>(OverShoulderCameraBoomName);
+	if (OverShoulderCameraBoom)
+	{
+		OverShoulderCameraBoom->SetupAttachment(GetCapsuleComponent());
+		OverShoulderCameraBoom->bUsePawnControlRotation = false; // Fixed Camera
+		OverShoulderCameraBoom->TargetArmLength = 75.0f;
+	}
 	
 	// Create a follow camera
-	OverShoulderCamera = CreateDefaultSubobject<UCameraComponent>(TEXT("ShoulderCamera"));
-	OverShoulderCamera->SetupAttachment(OverShoulderCameraBoom, USpringArmComponent::SocketName); // Attach the camera to the end of the boom and let the boom adjust to match the controller orientation
-	OverShoulderCamera->bUsePawnControlRotation = false;
+	OverShoulderCamera = CreateOptionalDefaultSubobject<UCameraComponent>(OverShoulderCameraName);
+	if (OverShoulderCamera)
+	{
+		OverShoulderCamera->SetupAttachment(OverShoulderCameraBoom, USpringArmComponent::SocketName); // Attach the camera to the end of the boom and let the boom adjust to match the controller orientation
+		OverShoulderCamera->bUsePawnControlRotation = false;
+	}
 	
 	USkeletalMeshComponent *Mesh = GetMesh();
 	Mesh->bCastDynamicShadow = true;
@@ -91,7 +226,10 @@ AVersatileCharacter::AVersatileCharacter()
 	CameraZoomMinimumDistance = 100.f;
 	CameraZoomCurrent = 300.f;
 	CameraZoomIncrement = 20.f;
-	CameraBoom->TargetArmLength = CameraZoomCurrent;
+	if (CameraBoom)
+	{
+		CameraBoom->TargetArmLength = CameraZoomCurrent;
+	}
 	
 	AutoResetSmoothFollowCameraWhenIdle = true;
 	AutoResetDelaySeconds = 2.5f;
@@ -99,6 +237,20 @@ AVersatileCharacter::AVersatileCharacter()
 	IsAutoReset = false;
 	AutoResetSpeed = .15f;
 	
+	ResetStartTime = 0.f;
+	LastControlYaw = 0.f;
+	
+	bViewComponentsCreatedOnDemand = false;
+	ViewComponentTemplateClass = AVersatileCharacter::StaticClass();
+	
+	bPrewarmNextCameraMode = true;
+	CameraModePrewarmSeconds = 3.f;
+	CameraModePrewarmUntil = 0.f;
+	bFirstPersonMeshesWarm = false;
+	PrewarmedCameraMode = ECharacterCameraMode::Max;
+	LastCameraModeChangeFrame = 0;
+	ArmsMeshUpdateFlag = EMeshComponentUpdateFlag::AlwaysTickPose;
+	BodyMeshUpdateFlag = EMeshComponentUpdateFlag::AlwaysTickPose;
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -141,6 +293,216 @@ void AVersatileCharacter::PostInitializeComponents()
 	UpdateForCameraMode();
 }
 
+void AVersatileCharacter::BeginPlay()
+{
+	Super::BeginPlay();
+	
+	AVersatileSignificanceManager* SignificanceManager = AVersatileSignificanceManager::Get(GetWorld());
+	if (SignificanceManager != nullptr)
+	{
+		SignificanceManager->RegisterCharacter(this);
+	}
+}
+
+void AVersatileCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	AVersatileSignificanceManager* SignificanceManager = AVersatileSignificanceManager::Find(GetWorld());
+	if (SignificanceManager != nullptr)
+	{
+		SignificanceManager->UnregisterCharacter(this);
+	}
+	
+	Super::EndPlay(EndPlayReason);
+}
+
+void AVersatileCharacter::PawnClientRestart()
+{
+	// Lightweight characters only get a camera rig once a local player is actually looking through them
+	if (Cast<APlayerController>(Controller) != nullptr && IsLocallyControlled())
+	{
+		CreateViewComponents();
+		
+		// Carry the player's camera preferences over from their previous pawn, level or session
+		AVersatilePlayerController* VersatileController = Cast<AVersatilePlayerController>(Controller);
+		if (VersatileController != nullptr && VersatileController->HasSavedCameraState())
+		{
+			ApplyCameraState(VersatileController->GetSavedCameraState());
+		}
+		
+		// Jitter is measured from here, not from whatever yaw the last pawn ended on
+		LastControlYaw = Controller->GetControlRotation().Yaw;
+	}
+	
+	Super::PawnClientRestart();
+}
+
+void AVersatileCharacter::UnPossessed()
+{
+	// Controller is cleared by the base implementation
+	AVersatilePlayerController* OldController = Cast<AVersatilePlayerController>(Controller);
+	
+	Super::UnPossessed();
+	ReleaseFromController(OldController);
+}
+
+void AVersatileCharacter::ReleaseFromController(AVersatilePlayerController* OldController)
+{
+	// Servers get here from UnPossessed; owning clients never see UnPossessed and get here from the controller's SetPawn
+	if (OldController != nullptr && OldController->IsLocalController())
+	{
+		OldController->SetSavedCameraState(GetCameraState());
+	}
+	
+	CoolFirstPersonMeshes();
+	ReleaseViewComponents(OldController);
+}
+
+// MARK: - On Demand View Components
+
+/** Creates an unregistered view component, copying its defaults from Template when one is available */
+template<class T>
+static T* NewViewComponent(AVersatileCharacter* Owner, FName Name, T* Template)
+{
+	const FName UniqueName = MakeUniqueObjectName(Owner, T::StaticClass(), Name);
+	return NewObject<T>(Owner, UniqueName, RF_Transient, Template);
+}
+
+bool AVersatileCharacter::HasViewComponents() const
+{
+	return CameraBoom && FollowCamera && FirstPersonCamera && ArmsMesh && BodyMesh && OverShoulderCameraBoom && OverShoulderCamera;
+}
+
+void AVersatileCharacter::CreateViewComponents()
+{
+	if (HasViewComponents()) return;
+	
+	// Release any partial set so the attachment hierarchy is always rebuilt as a whole
+	ReleaseViewComponents();
+	
+	// Reuse the rig parked on our controller by the last pawn it possessed, if there is one
+	AVersatilePlayerController* VersatileController = Cast<AVersatilePlayerController>(Controller);
+	FVersatileCameraRig PooledRig;
+	if (VersatileController != nullptr && VersatileController->ClaimCameraRig(ViewComponentTemplateClass, PooledRig))
+	{
+		AdoptCameraRig(PooledRig);
+		SetActorTickEnabled(true);
+		UpdateForCameraMode();
+		return;
+	}
+	
+	const AVersatileCharacter* Template = ViewComponentTemplateClass ? ViewComponentTemplateClass->GetDefaultObject<AVersatileCharacter>() : nullptr;
+	if (Template == nullptr || !Template->HasViewComponents())
+	{
+		Template = GetDefault<AVersatileCharacter>();
+	}
+	
+	CameraBoom = NewViewComponent<USpringArmComponent>(this, CameraBoomName, Template->CameraBoom);
+	CameraBoom->SetupAttachment(GetCapsuleComponent());
+	
+	FollowCamera = NewViewComponent<UCameraComponent>(this, FollowCameraName, Template->FollowCamera);
+	FollowCamera->SetupAttachment(CameraBoom, USpringArmComponent::SocketName);
+	
+	FirstPersonCamera = NewViewComponent<UCameraComponent>(this, FirstPersonCameraName, Template->FirstPersonCamera);
+	FirstPersonCamera->SetupAttachment(GetCapsuleComponent());
+	
+	ArmsMesh = NewViewComponent<USkeletalMeshComponent>(this, ArmsMeshName, Template->ArmsMesh);
+	ArmsMesh->SetupAttachment(FirstPersonCamera);
+	
+	BodyMesh = NewViewComponent<USkeletalMeshComponent>(this, BodyMeshName, Template->BodyMesh);
+	BodyMesh->SetupAttachment(GetCapsuleComponent());
+	
+	OverShoulderCameraBoom = NewViewComponent<USpringArmComponent>(this, OverShoulderCameraBoomName, Template->OverShoulderCameraBoom);
+	OverShoulderCameraBoom->SetupAttachment(GetCapsuleComponent());
+	
+	OverShoulderCamera = NewViewComponent<UCameraComponent>(this, OverShoulderCameraName, Template->OverShoulderCamera);
+	OverShoulderCamera->SetupAttachment(OverShoulderCameraBoom, USpringArmComponent::SocketName);
+	
+	// Parents are registered before their children
+	CameraBoom->RegisterComponent();
+	FollowCamera->RegisterComponent();
+	FirstPersonCamera->RegisterComponent();
+	ArmsMesh->RegisterComponent();
+	BodyMesh->RegisterComponent();
+	OverShoulderCameraBoom->RegisterComponent();
+	OverShoulderCamera->RegisterComponent();
+	
+	bViewComponentsCreatedOnDemand = true;
+	CameraBoom->TargetArmLength = CameraZoomCurrent;
+	
+	SetActorTickEnabled(true);
+	UpdateForCameraMode();
+}
+
+void AVersatileCharacter::ReleaseViewComponents(AVersatilePlayerController* PoolOwner)
+{
+	if (!bViewComponentsCreatedOnDemand) return;
+	
+	// Pooled meshes go back to their normal flags before the next pawn adopts them
+	CoolFirstPersonMeshes();
+	
+	FVersatileCameraRig Rig = GetCameraRig();
+	if (PoolOwner != nullptr && PoolOwner->bPoolCameraRig && Rig.IsComplete())
+	{
+		Rig.MoveTo(PoolOwner, nullptr);
+		PoolOwner->ParkCameraRig(Rig);
+	}
+	else
+	{
+		Rig.DestroyComponents();
+	}
+	
+	OverShoulderCamera = nullptr;
+	OverShoulderCameraBoom = nullptr;
+	BodyMesh = nullptr;
+	ArmsMesh = nullptr;
+	FirstPersonCamera = nullptr;
+	FollowCamera = nullptr;
+	CameraBoom = nullptr;
+	
+	bViewComponentsCreatedOnDemand = false;
+	bIsResetting = false;
+	IsAutoReset = false;
+	
+	// The only per-frame work on this class is camera logic
+	SetActorTickEnabled(false);
+}
+
+FVersatileCameraRig AVersatileCharacter::GetCameraRig() const
+{
+	FVersatileCameraRig Rig;
+	Rig.CameraBoom = CameraBoom;
+	Rig.FollowCamera = FollowCamera;
+	Rig.FirstPersonCamera = FirstPersonCamera;
+	Rig.ArmsMesh = ArmsMesh;
+	Rig.BodyMesh = BodyMesh;
+	Rig.OverShoulderCameraBoom = OverShoulderCameraBoom;
+	Rig.OverShoulderCamera = OverShoulderCamera;
+	Rig.CameraMode = CameraModeEnum;
+	Rig.CameraZoomCurrent = CameraZoomCurrent;
+	Rig.TemplateClass = ViewComponentTemplateClass;
+	return Rig;
+}
+
+void AVersatileCharacter::AdoptCameraRig(const FVersatileCameraRig& Rig)
+{
+	Rig.MoveTo(this, GetCapsuleComponent());
+	
+	CameraBoom = Rig.CameraBoom;
+	FollowCamera = Rig.FollowCamera;
+	FirstPersonCamera = Rig.FirstPersonCamera;
+	ArmsMesh = Rig.ArmsMesh;
+	BodyMesh = Rig.BodyMesh;
+	OverShoulderCameraBoom = Rig.OverShoulderCameraBoom;
+	OverShoulderCamera = Rig.OverShoulderCamera;
+	
+	// Zoom and mode follow the player; spring arm lag state lives on the booms and comes along with them
+	CameraModeEnum = Rig.CameraMode;
+	CameraZoomCurrent = Rig.CameraZoomCurrent;
+	CameraBoom->TargetArmLength = CameraZoomCurrent;
+	
+	bViewComponentsCreatedOnDemand = true;
+}
+
 void AVersatileCharacter::ZoomCameraIn()
 {
 	GEngine->AddOnScreenDebugMessage(-1, 5.f, FColor::White, "Zoom Camera In Requested");
@@ -148,7 +510,10 @@ void AVersatileCharacter::ZoomCameraIn()
 	if (CameraZoomCurrent < CameraZoomMinimumDistance)
 		CameraZoomCurrent = CameraZoomMinimumDistance;
 	
-	CameraBoom->TargetArmLength = CameraZoomCurrent;
+	if (CameraBoom)
+		CameraBoom->TargetArmLength = CameraZoomCurrent;
+	
+	StoreCameraStateOnController();
 }
 void AVersatileCharacter::ZoomCameraOut()
 {
@@ -157,17 +522,25 @@ void AVersatileCharacter::ZoomCameraOut()
 	if (CameraZoomCurrent > CameraZoomMaximumDistance)
 		CameraZoomCurrent = CameraZoomMaximumDistance;
 	
-	CameraBoom->TargetArmLength = CameraZoomCurrent;
+	if (CameraBoom)
+		CameraBoom->TargetArmLength = CameraZoomCurrent;
+	
+	StoreCameraStateOnController();
 }
 
 
 void AVersatileCharacter::CycleCamera()
 {
 	GEngine->AddOnScreenDebugMessage(-1, 5.f, FColor::White, "Cycle Camera Requested");
+	SetCameraMode(GetNextCameraMode());
+}
+
+ECharacterCameraMode::Type AVersatileCharacter::GetNextCameraMode() const
+{
 	int newCameraMode = (int)CameraModeEnum + 1;
 	
 	if (newCameraMode >= ECharacterCameraMode::Max) newCameraMode = ECharacterCameraMode::ThirdPersonDefault;
-	SetCameraMode((ECharacterCameraMode::Type)newCameraMode);
+	return (ECharacterCameraMode::Type)newCameraMode;
 }
 
 
@@ -176,7 +549,10 @@ void AVersatileCharacter::SetCameraMode(ECharacterCameraMode::Type newCameraMode
 	GEngine->AddOnScreenDebugMessage(-1, 5.f, FColor::White, "Setting Camera Mode to " + GetNameForCameraMode(newCameraMode));
 	CameraModeEnum = newCameraMode;
 	UpdateForCameraMode();
+	StoreCameraStateOnController();
 	
+	// A player who just switched is the one likely to switch again
+	CameraModePrewarmUntil = FApp::GetCurrentTime() + CameraModePrewarmSeconds;
 }
 
 void AVersatileCharacter::OnResetVR()
@@ -263,62 +639,252 @@ void AVersatileCharacter::HandleYawInput(float turnInput)
 // MARK: - Camera Mode
 void AVersatileCharacter::UpdateForCameraMode()
 {
+	ApplyCameraModeRotationSettings();
+	
+	// Lightweight characters have nothing to show or view through until a local player possesses them
+	if (!HasViewComponents()) return;
+	
 	// Changes visibility of first and third person meshes
+	UpdateMeshVisibilityForCameraMode();
+	
 	switch (CameraModeEnum)
 	{
 		case ECharacterCameraMode::ThirdPersonDefault:
 			bIsResetting = false;
 			// no break is intentional
 		case ECharacterCameraMode::ThirdPersonSmoothFollow:
-			bUseControllerRotationYaw = false;
-			GetMesh()->bOwnerNoSee = false;
-			GetMesh()->MarkRenderStateDirty();
-			ArmsMesh->bVisible = false;
-			ArmsMesh->MarkRenderStateDirty();
-			BodyMesh->bVisible = false;
-			BodyMesh->MarkRenderStateDirty();
-			GetCharacterMovement()->bOrientRotationToMovement = true;
 			SetActiveCameraComponent(FollowCamera);
 			break;
 		case ECharacterCameraMode::FirstPerson:
-			bUseControllerRotationYaw = true;
-			GetMesh()->bOwnerNoSee = true;
-			GetMesh()->MarkRenderStateDirty();
 			bIsResetting = false;
-			ArmsMesh->bVisible = true;
-			ArmsMesh->MarkRenderStateDirty();
-			BodyMesh->bVisible = true;
-			BodyMesh->MarkRenderStateDirty();
 			SetActiveCameraComponent(FirstPersonCamera);
 			break;
-			GetCharacterMovement()->bOrientRotationToMovement = false;
 		case ECharacterCameraMode::ThirdPersonOverShoulder:
-			bUseControllerRotationYaw = false;
 			bIsResetting = false;
-			GetMesh()->bOwnerNoSee = false;
-			GetMesh()->MarkRenderStateDirty();
-			ArmsMesh->bVisible = false;
-			ArmsMesh->MarkRenderStateDirty();
-			BodyMesh->bVisible = false;
-			BodyMesh->MarkRenderStateDirty();
 			SetActiveCameraComponent(OverShoulderCamera);
-			GetCharacterMovement()->bOrientRotationToMovement = false;
 			break;
 		default:
 			break;
 	}
 	
-	APlayerController* OurPlayerController = UGameplayStatics::GetPlayerController(this, 0);
-	if (OurPlayerController != nullptr)
+	// The next mode is prepared on a later frame, so its cost never lands on the frame of a switch
+	PrewarmedCameraMode = ECharacterCameraMode::Max;
+	LastCameraModeChangeFrame = GFrameCounter;
+	
+	// Only our own local player looks through us; spawning or switching another character must not move their camera
+	APlayerController* OurPlayerController = Cast<APlayerController>(Controller);
+	if (OurPlayerController != nullptr && IsLocallyControlled())
 	{
 		OurPlayerController->SetViewTargetWithBlend(this, .25f, EViewTargetBlendFunction::VTBlend_EaseIn);
 	}
 }
 
+void AVersatileCharacter::UpdateMeshVisibilityForCameraMode()
+{
+	// Warm meshes keep their render state; the owner's view hides whichever the mode does not show
+	if (bFirstPersonMeshesWarm) return;
+	
+	const bool bFirstPerson = IsFirstPerson(CameraModeEnum);
+	GetMesh()->bOwnerNoSee = bFirstPerson;
+	GetMesh()->MarkRenderStateDirty();
+	ArmsMesh->bVisible = bFirstPerson;
+	ArmsMesh->MarkRenderStateDirty();
+	BodyMesh->bVisible = bFirstPerson;
+	BodyMesh->MarkRenderStateDirty();
+}
+
+void AVersatileCharacter::ApplyCameraModeRotationSettings()
+{
+	// First person faces where the controller looks, the follow cameras turn the character towards
+	// its movement, and over shoulder leaves rotation alone
+	const bool bFirstPerson = (CameraModeEnum == ECharacterCameraMode::FirstPerson);
+	const bool bFollow = (CameraModeEnum == ECharacterCameraMode::ThirdPersonDefault || CameraModeEnum == ECharacterCameraMode::ThirdPersonSmoothFollow);
+	
+	bUseControllerRotationYaw = bFirstPerson;
+	GetCharacterMovement()->bOrientRotationToMovement = bFollow;
+}
+
+void AVersatileCharacter::SetCameraModeFromMove(ECharacterCameraMode::Type MoveCameraMode)
+{
+	// The owning client is the authority on its camera mode; everyone else just follows its rotation settings
+	if (IsLocallyControlled() || MoveCameraMode >= ECharacterCameraMode::Max || MoveCameraMode == CameraModeEnum) return;
+	
+	CameraModeEnum = MoveCameraMode;
+	ApplyCameraModeRotationSettings();
+}
+
+// MARK: - Camera Mode Prewarm
+
+bool AVersatileCharacter::ShouldPrewarmNextCameraMode() const
+{
+	return bPrewarmNextCameraMode && CVarVersatileCameraPrewarm.GetValueOnGameThread() != 0;
+}
+
+bool AVersatileCharacter::IsCameraModePrewarmed(ECharacterCameraMode::Type NextCameraMode) const
+{
+	if (!HasViewComponents()) return false;
+	
+	// Switching between third person modes only changes the active camera, whose boom updates every tick
+	const bool bCrossesFirstPerson = IsFirstPerson(NextCameraMode) != IsFirstPerson(CameraModeEnum);
+	return !bCrossesFirstPerson || bFirstPersonMeshesWarm;
+}
+
+bool AVersatileCharacter::PrewarmCameraMode(ECharacterCameraMode::Type NextCameraMode)
+{
+	if (NextCameraMode >= ECharacterCameraMode::Max) return false;
+	
+	if (!IsCameraModePrewarmed(NextCameraMode))
+	{
+		if (!HasViewComponents() || !IsLocallyControlled() || Cast<AVersatilePlayerController>(Controller) == nullptr) return false;
+		
+		// Hidden meshes only tick their pose, so have them refresh bones too and be current when shown
+		ArmsMeshUpdateFlag = ArmsMesh->MeshComponentUpdateFlag;
+		BodyMeshUpdateFlag = BodyMesh->MeshComponentUpdateFlag;
+		ArmsMesh->MeshComponentUpdateFlag = EMeshComponentUpdateFlag::AlwaysTickPoseAndRefreshBones;
+		BodyMesh->MeshComponentUpdateFlag = EMeshComponentUpdateFlag::AlwaysTickPoseAndRefreshBones;
+		
+		// All three meshes are visible to the owner from here on; GetOwnerViewHiddenComponents picks per mode
+		bFirstPersonMeshesWarm = true;
+		if (!ArmsMesh->bVisible)
+		{
+			ArmsMesh->bVisible = true;
+			ArmsMesh->MarkRenderStateDirty();
+		}
+		if (!BodyMesh->bVisible)
+		{
+			BodyMesh->bVisible = true;
+			BodyMesh->MarkRenderStateDirty();
+		}
+		if (GetMesh()->bOwnerNoSee)
+		{
+			GetMesh()->bOwnerNoSee = false;
+			GetMesh()->MarkRenderStateDirty();
+		}
+	}
+	
+	PrewarmedCameraMode = NextCameraMode;
+	CameraModePrewarmUntil = FMath::Max(CameraModePrewarmUntil, (float)FApp::GetCurrentTime() + CameraModePrewarmSeconds);
+	return true;
+}
+
+void AVersatileCharacter::GetOwnerViewHiddenComponents(TSet<FPrimitiveComponentId>& HiddenComponents) const
+{
+	if (!bFirstPersonMeshesWarm || !HasViewComponents()) return;
+	
+	if (IsFirstPerson(CameraModeEnum))
+	{
+		HiddenComponents.Add(GetMesh()->ComponentId);
+	}
+	else
+	{
+		HiddenComponents.Add(ArmsMesh->ComponentId);
+		HiddenComponents.Add(BodyMesh->ComponentId);
+	}
+}
+
+void AVersatileCharacter::UpdateCameraModePrewarm()
+{
+	// Leave the frame of a switch to the switch itself
+	if (LastCameraModeChangeFrame == GFrameCounter) return;
+	
+	const bool bInPrewarmWindow = FApp::GetCurrentTime() < CameraModePrewarmUntil;
+	if (bInPrewarmWindow && ShouldPrewarmNextCameraMode())
+	{
+		// Leave a mode prepared through PrewarmCameraMode alone
+		if (PrewarmedCameraMode == ECharacterCameraMode::Max)
+		{
+			PrewarmCameraMode(GetNextCameraMode());
+		}
+	}
+	
+	// Keeping the first person meshes warm costs their animation and render state, so only do it while needed
+	if (bFirstPersonMeshesWarm && !IsFirstPerson(CameraModeEnum) && (!bInPrewarmWindow || !IsFirstPerson(PrewarmedCameraMode)))
+	{
+		CoolFirstPersonMeshes();
+	}
+}
+
+void AVersatileCharacter::CoolFirstPersonMeshes()
+{
+	if (!bFirstPersonMeshesWarm) return;
+	
+	bFirstPersonMeshesWarm = false;
+	PrewarmedCameraMode = ECharacterCameraMode::Max;
+	if (!HasViewComponents()) return;
+	
+	ArmsMesh->MeshComponentUpdateFlag = ArmsMeshUpdateFlag;
+	BodyMesh->MeshComponentUpdateFlag = BodyMeshUpdateFlag;
+	UpdateMeshVisibilityForCameraMode();
+}
+
+// MARK: - Camera State
+
+FVersatileCameraState AVersatileCharacter::GetCameraState() const
+{
+	FVersatileCameraState State;
+	State.CameraMode = (uint8)CameraModeEnum;
+	State.CameraZoomCurrent = CameraZoomCurrent;
+	State.CameraFollowTurnAngleExponent = CameraFollowTurnAngleExponent;
+	State.CameraFollowTurnRate = CameraFollowTurnRate;
+	State.CameraResetSpeed = CameraResetSpeed;
+	State.AutoResetDelaySeconds = AutoResetDelaySeconds;
+	State.AutoResetSpeed = AutoResetSpeed;
+	State.bAutoResetSmoothFollowCameraWhenIdle = AutoResetSmoothFollowCameraWhenIdle;
+	return State;
+}
+
+void AVersatileCharacter::ApplyCameraState(const FVersatileCameraState& State)
+{
+	CameraZoomCurrent = FMath::Clamp(State.CameraZoomCurrent, CameraZoomMinimumDistance, CameraZoomMaximumDistance);
+	CameraFollowTurnAngleExponent = State.CameraFollowTurnAngleExponent;
+	CameraFollowTurnRate = State.CameraFollowTurnRate;
+	CameraResetSpeed = State.CameraResetSpeed;
+	AutoResetDelaySeconds = State.AutoResetDelaySeconds;
+	AutoResetSpeed = State.AutoResetSpeed;
+	AutoResetSmoothFollowCameraWhenIdle = State.bAutoResetSmoothFollowCameraWhenIdle;
+	
+	if (CameraBoom)
+		CameraBoom->TargetArmLength = CameraZoomCurrent;
+	
+	if (State.CameraMode < ECharacterCameraMode::Max && State.CameraMode != CameraModeEnum)
+	{
+		CameraModeEnum = (ECharacterCameraMode::Type)State.CameraMode;
+		UpdateForCameraMode();
+	}
+}
+
+void AVersatileCharacter::StoreCameraStateOnController() const
+{
+	AVersatilePlayerController* VersatileController = Cast<AVersatilePlayerController>(Controller);
+	if (VersatileController != nullptr && VersatileController->IsLocalController())
+	{
+		VersatileController->SetSavedCameraState(GetCameraState());
+	}
+}
+
+// MARK: - Mirror View
+
+void AVersatileCharacter::PrepareMirrorCapture(USceneCaptureComponent* Capture) const
+{
+	if (Capture == nullptr) return;
+	
+	// Hidden components are held weakly, so components released with a camera rig drop out on their own
+	if (ArmsMesh != nullptr)
+	{
+		Capture->HideComponent(ArmsMesh);
+	}
+	if (BodyMesh != nullptr)
+	{
+		Capture->HideComponent(BodyMesh);
+	}
+}
+
 // MARK: - Camera Animation
 
 void AVersatileCharacter::SetActiveCameraComponent(UCameraComponent *component)
 {
+	if (!HasViewComponents()) return;
+	
 	FollowCamera->SetActive(false);
 	FirstPersonCamera->SetActive(false);
 	OverShoulderCamera->SetActive(false);
@@ -360,6 +926,14 @@ void AVersatileCharacter::_ResettingTick(float DeltaSeconds)
 	
 	if (fabsf(delta) <= 1.f)
 	{
+		// Resets that are already lined up finish on their first tick and are not worth recording
+		const float ResetDuration = FApp::GetCurrentTime() - ResetStartTime;
+		FVersatileCameraTelemetry* Telemetry = GetCameraTelemetry();
+		if (Telemetry != nullptr && ResetDuration > 0.f)
+		{
+			Telemetry->RecordReset(ResetDuration, IsAutoReset);
+		}
+		
 		bIsResetting = false;
 		IsAutoReset = false;
 	}
@@ -378,6 +952,10 @@ void AVersatileCharacter::_SmoothFollowTick(float DeltaSeconds)
 	
 	if (currentTime > LastMovementTime + AutoResetDelaySeconds)
 	{
+		if (!bIsResetting)
+		{
+			ResetStartTime = currentTime;
+		}
 		IsAutoReset = true;
 		bIsResetting = true;
 	}
@@ -413,6 +991,8 @@ void AVersatileCharacter::Tick(float DeltaSeconds)
 {
 	Super::Tick(DeltaSeconds);
 	
+	if (Controller == nullptr || !HasViewComponents()) return;
+	
 	if (CameraModeEnum == ECharacterCameraMode::ThirdPersonSmoothFollow)
 	{
 		_SmoothFollowTick(DeltaSeconds);
@@ -422,4 +1002,27 @@ void AVersatileCharacter::Tick(float DeltaSeconds)
 
 	}
 	
+	UpdateCameraModePrewarm();
+	RecordCameraTelemetry(DeltaSeconds);
+}
+
+// MARK: - Camera Telemetry
+
+FVersatileCameraTelemetry* AVersatileCharacter::GetCameraTelemetry() const
+{
+	AVersatilePlayerController* VersatileController = Cast<AVersatilePlayerController>(Controller);
+	return VersatileController ? VersatileController->GetCameraTelemetry() : nullptr;
+}
+
+void AVersatileCharacter::RecordCameraTelemetry(float DeltaSeconds)
+{
+	const float ControlYaw = Controller->GetControlRotation().Yaw;
+	const float YawDelta = FRotator::NormalizeAxis(ControlYaw - LastControlYaw);
+	LastControlYaw = ControlYaw;
+	
+	FVersatileCameraTelemetry* Telemetry = GetCameraTelemetry();
+	if (Telemetry != nullptr)
+	{
+		Telemetry->RecordFrame(CameraModeEnum, DeltaSeconds, YawDelta, CameraZoomCurrent);
+	}
 }
@@ -1,6 +1,7 @@
 // Copyright 1998-2017 Epic Games, Inc. All Rights Reserved.
 #pragma once
 #include "GameFramework/Character.h"
+#include "VersatileCameraState.h"
 #include "VersatileCharacter.generated.h"
 
 
@@ -50,6 +51,69 @@ static inline FString GetNameForCameraMode(const ECharacterCameraMode::Type Came
 	return TEXT("");
 }
 
+// MARK: - Camera Rig
+
+/**
+ * The camera and first person components of a Versatile character, together with the camera state
+ * that should follow them. Lets a rig be parked on a player controller and handed to the next pawn.
+ */
+USTRUCT()
+struct FVersatileCameraRig
+{
+	GENERATED_BODY()
+	
+	UPROPERTY()
+	class USpringArmComponent* CameraBoom;
+	
+	UPROPERTY()
+	class UCameraComponent* FollowCamera;
+	
+	UPROPERTY()
+	class UCameraComponent* FirstPersonCamera;
+	
+	UPROPERTY()
+	class USkeletalMeshComponent* ArmsMesh;
+	
+	UPROPERTY()
+	class USkeletalMeshComponent* BodyMesh;
+	
+	UPROPERTY()
+	class USpringArmComponent* OverShoulderCameraBoom;
+	
+	UPROPERTY()
+	class UCameraComponent* OverShoulderCamera;
+	
+	/** Camera mode the rig was last used in */
+	UPROPERTY()
+	TEnumAsByte<ECharacterCameraMode::Type> CameraMode;
+	
+	/** Follow camera zoom distance the rig was last used with */
+	UPROPERTY()
+	float CameraZoomCurrent;
+	
+	/** ViewComponentTemplateClass of the character the rig was built for; its meshes and camera tuning come from it */
+	UPROPERTY()
+	TSubclassOf<class AVersatileCharacter> TemplateClass;
+	
+	FVersatileCameraRig();
+	
+	/** Whether every component of the rig is present */
+	bool IsComplete() const;
+	
+	/**
+	 * Moves every component to a new owning actor without re-registering them.
+	 * @param NewOwner		The actor that will own the components
+	 * @param AttachParent	Component the rig is attached to, or nullptr to park the rig detached and idle
+	 */
+	void MoveTo(AActor* NewOwner, class USceneComponent* AttachParent) const;
+	
+	/** Destroys every component of the rig and clears it */
+	void DestroyComponents();
+	
+	/** Clears the rig without touching its components */
+	void Reset();
+};
+
 // MARK: - AVersatileCharacter
 
 UCLASS(config=Game)
@@ -146,9 +210,71 @@ protected:
 	UPROPERTY(Transient)
 	bool IsAutoReset;
 	
+	/** When the current camera reset started */
+	UPROPERTY(Transient)
+	float ResetStartTime;
+	
+	/** Control yaw at the end of the last tick, for camera telemetry */
+	UPROPERTY(Transient)
+	float LastControlYaw;
+	
+	/** Whether the camera and first person components were created at possession rather than in the constructor */
+	UPROPERTY(Transient)
+	bool bViewComponentsCreatedOnDemand;
+	
+	/**
+	 * Whether the first person meshes are kept visible with a current pose. While they are, the owning
+	 * player controller's hidden components decide which meshes the owner sees, not visibility flags.
+	 */
+	UPROPERTY(Transient)
+	bool bFirstPersonMeshesWarm;
+	
+	/** Camera mode prepared by the last PrewarmCameraMode call since the mode changed */
+	TEnumAsByte<ECharacterCameraMode::Type> PrewarmedCameraMode;
+	
+	/** Frame the camera mode last changed on */
+	uint64 LastCameraModeChangeFrame;
+	
+	/** App time until which the prepared camera mode is kept ready */
+	float CameraModePrewarmUntil;
+	
+	/** First person mesh update flags from before they were warmed */
+	TEnumAsByte<EMeshComponentUpdateFlag::Type> ArmsMeshUpdateFlag;
+	TEnumAsByte<EMeshComponentUpdateFlag::Type> BodyMeshUpdateFlag;
+	
 	
 public:
-	AVersatileCharacter();
+	AVersatileCharacter(const FObjectInitializer& ObjectInitializer = FObjectInitializer::Get());
+	
+	/** Names of the camera and first person subobjects, usable with FObjectInitializer::DoNotCreateDefaultSubobject */
+	static FName ArmsMeshName;
+	static FName BodyMeshName;
+	static FName CameraBoomName;
+	static FName FollowCameraName;
+	static FName FirstPersonCameraName;
+	static FName OverShoulderCameraBoomName;
+	static FName OverShoulderCameraName;
+	
+	/**
+	 * Class whose defaults are copied when the camera and first person components are created on demand.
+	 * Point this at the full character Blueprint so meshes and camera tuning match.
+	 */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category=Lightweight)
+	TSubclassOf<AVersatileCharacter> ViewComponentTemplateClass;
+	
+	/**
+	 * Whether the camera mode CycleCamera would switch to next is prepared a frame after each switch,
+	 * so a following switch only changes the active camera and what the owner's view hides
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=Camera)
+	bool bPrewarmNextCameraMode;
+	
+	/**
+	 * Seconds a prepared camera mode is kept ready after a switch or a PrewarmCameraMode call.
+	 * Keeping first person ready costs its meshes' animation every frame, so it is let go after this.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=Camera, meta=(ClampMin="0.0"))
+	float CameraModePrewarmSeconds;
 	
 	/** Base turn rate, in deg/sec. Other scaling may affect final turn rate. */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category=Camera)
@@ -196,9 +322,55 @@ protected:
 	/** Handles setting of properties based on camera mode value */
 	void UpdateForCameraMode();
 	
+public:
+	/** Sets controller yaw and orient-to-movement rotation for the current camera mode */
+	void ApplyCameraModeRotationSettings();
+	
+	/**
+	 * Adopts the camera mode an owning client sent with its saved moves, so the server rotates the
+	 * character the same way the client predicted. Ignored for locally controlled characters.
+	 * @param MoveCameraMode	Camera mode packed into the move
+	 */
+	void SetCameraModeFromMove(ECharacterCameraMode::Type MoveCameraMode);
+	
 	/** Cycles to the next camera mode */
 	void CycleCamera();
 	
+	/** Returns the camera mode CycleCamera switches to from the current one */
+	ECharacterCameraMode::Type GetNextCameraMode() const;
+	
+	/**
+	 * Prepares a camera mode ahead of switching to it: the meshes it shows get render state and keep
+	 * their pose current while hidden from the owner's view. Only locally controlled characters with a
+	 * Versatile player controller can be prepared, since that controller does the hiding. The mode stays
+	 * ready for CameraModePrewarmSeconds, so call this on intent, e.g. when a mode menu opens.
+	 * @param NextCameraMode	The camera mode about to be switched to
+	 * @return Whether switching to the mode is now only a flip of the active camera and hidden components
+	 */
+	bool PrewarmCameraMode(ECharacterCameraMode::Type NextCameraMode);
+	
+	/** Whether bPrewarmNextCameraMode is set and versatile.CameraPrewarm allows it */
+	bool ShouldPrewarmNextCameraMode() const;
+	
+	/** Whether switching to a camera mode needs no render state or animation changes */
+	bool IsCameraModePrewarmed(ECharacterCameraMode::Type NextCameraMode) const;
+	
+	/**
+	 * Adds the meshes the owner's view should not show in the current camera mode while the first
+	 * person meshes are warm. Called by the owning player controller for each view it renders.
+	 * @param HiddenComponents	Components hidden from the view
+	 */
+	void GetOwnerViewHiddenComponents(TSet<FPrimitiveComponentId>& HiddenComponents) const;
+	
+	/**
+	 * Saves the camera state to the controller that just stopped controlling this character and releases
+	 * the camera rig, parking it on that controller when it pools rigs. Safe to call more than once.
+	 * @param OldController	The controller that let go, or nullptr
+	 */
+	void ReleaseFromController(class AVersatilePlayerController* OldController);
+	
+protected:
+	
 	/**
 	 * Zooms the camera in one increment
 	 */
@@ -225,10 +397,29 @@ protected:
 	 * Whether the current camera mode is a third person mode.
 	 */
 	bool IsInThirdPersonMode();
+	
+	/**
+	 * Whether this character currently has its camera and first person components.
+	 */
+	bool HasViewComponents() const;
+	
+	/**
+	 * Creates and registers any camera and first person components skipped at construction,
+	 * using ViewComponentTemplateClass defaults as templates.
+	 */
+	void CreateViewComponents();
+	
+	/**
+	 * Releases the camera and first person components if they were created on demand.
+	 * @param PoolOwner	Controller to park the components on for the next pawn, or nullptr to destroy them
+	 */
+	void ReleaseViewComponents(class AVersatilePlayerController* PoolOwner = nullptr);
 
 protected:
 	// APawn interface
 	virtual void SetupPlayerInputComponent(class UInputComponent* PlayerInputComponent) override;
+	virtual void PawnClientRestart() override;
+	virtual void UnPossessed() override;
 	// End of APawn interface
 
 public:
@@ -236,8 +427,33 @@ public:
 	FORCEINLINE class USpringArmComponent* GetCameraBoom() const { return CameraBoom; }
 	/** Returns FollowCamera subobject **/
 	FORCEINLINE class UCameraComponent* GetFollowCamera() const { return FollowCamera; }
+	/** Returns ArmsMesh subobject, which may be null on lightweight characters **/
+	FORCEINLINE class USkeletalMeshComponent* GetArmsMesh() const { return ArmsMesh; }
+	/** Returns BodyMesh subobject, which may be null on lightweight characters **/
+	FORCEINLINE class USkeletalMeshComponent* GetBodyMesh() const { return BodyMesh; }
+	
+	/**
+	 * Mirror view mode: sets up a reflection capture so this character shows its third person mesh.
+	 * The first person arms and body are hidden from the capture; the third person mesh is only hidden
+	 * from this character's owner, so it stays visible to a capture owned by the mirror.
+	 * @param Capture	The reflection capture about to render
+	 */
+	void PrepareMirrorCapture(class USceneCaptureComponent* Capture) const;
+	
+	/**
+	 * Returns the camera mode, zoom and follow tuning as a compact record.
+	 */
+	FVersatileCameraState GetCameraState() const;
+	
+	/**
+	 * Restores camera mode, zoom and follow tuning from a record.
+	 * @param State	The record to restore
+	 */
+	void ApplyCameraState(const FVersatileCameraState& State);
 	
 	virtual void PostInitializeComponents();
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 	virtual void Tick(float Delay);
 	
 private:
@@ -246,6 +462,30 @@ private:
 	
 	
 	UCameraComponent * GetActiveCameraComponent();
+	
+	/** Packages the current view components and camera state into a rig */
+	FVersatileCameraRig GetCameraRig() const;
+	
+	/** Attaches a pooled camera rig to this character and restores its camera state */
+	void AdoptCameraRig(const FVersatileCameraRig& Rig);
+	
+	/** Camera telemetry of the local Versatile player controlling this character, or nullptr */
+	struct FVersatileCameraTelemetry* GetCameraTelemetry() const;
+	
+	/** Feeds this frame's camera behaviour to the local player's camera telemetry */
+	void RecordCameraTelemetry(float DeltaSeconds);
+	
+	/** Hands the current camera state to a local Versatile player controller so it survives respawn and travel */
+	void StoreCameraStateOnController() const;
+	
+	/** Shows and hides the first and third person meshes for the current camera mode, unless they are warm */
+	void UpdateMeshVisibilityForCameraMode();
+	
+	/** Prepares the next camera mode and lets the first person meshes go once no mode near needs them */
+	void UpdateCameraModePrewarm();
+	
+	/** Returns the first person meshes to their normal update flags and visibility */
+	void CoolFirstPersonMeshes();
 
 public:
 
@@ -0,0 +1,157 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Versatile.h"
+#include "VersatileCharacterMovementComponent.h"
+#include "VersatileCharacter.h"
+
+//////////////////////////////////////////////////////////////////////////
+// UVersatileCharacterMovementComponent
+
+UVersatileCharacterMovementComponent::UVersatileCharacterMovementComponent()
+{
+	MovementDrivenAccelDotThresholdCombine = .98f;
+}
+
+FNetworkPredictionData_Client* UVersatileCharacterMovementComponent::GetPredictionData_Client() const
+{
+	if (ClientPredictionData == nullptr)
+	{
+		UVersatileCharacterMovementComponent* MutableThis = const_cast<UVersatileCharacterMovementComponent*>(this);
+		MutableThis->ClientPredictionData = new FNetworkPredictionData_Client_Versatile(*this);
+	}
+	return ClientPredictionData;
+}
+
+void UVersatileCharacterMovementComponent::UpdateFromCompressedFlags(uint8 Flags)
+{
+	Super::UpdateFromCompressedFlags(Flags);
+	
+	AVersatileCharacter* Character = Cast<AVersatileCharacter>(CharacterOwner);
+	if (Character != nullptr)
+	{
+		const uint8 CameraMode = (Flags & CameraModeFlagMask) >> CameraModeFlagShift;
+		Character->SetCameraModeFromMove((ECharacterCameraMode::Type)CameraMode);
+	}
+}
+
+bool UVersatileCharacterMovementComponent::ClientUpdatePositionAfterServerUpdate()
+{
+	const bool bResult = Super::ClientUpdatePositionAfterServerUpdate();
+	
+	// Replayed moves apply the rotation settings they were saved with, so put back the current ones
+	AVersatileCharacter* Character = Cast<AVersatileCharacter>(CharacterOwner);
+	if (Character != nullptr)
+	{
+		Character->ApplyCameraModeRotationSettings();
+	}
+	return bResult;
+}
+
+void UVersatileCharacterMovementComponent::CallServerMove(const FSavedMove_Character* NewMove, const FSavedMove_Character* OldMove)
+{
+	NetCounters.MovesSent++;
+	if (OldMove != nullptr)
+	{
+		NetCounters.DualMovesSent++;
+	}
+	
+	Super::CallServerMove(NewMove, OldMove);
+}
+
+void UVersatileCharacterMovementComponent::ClientAdjustPosition_Implementation(float TimeStamp, FVector NewLoc, FVector NewVel, UPrimitiveComponent* NewBase, FName NewBaseBoneName, bool bHasBase, bool bBaseRelativePosition, uint8 ServerMovementMode)
+{
+	NetCounters.Corrections++;
+	Super::ClientAdjustPosition_Implementation(TimeStamp, NewLoc, NewVel, NewBase, NewBaseBoneName, bHasBase, bBaseRelativePosition, ServerMovementMode);
+}
+
+void UVersatileCharacterMovementComponent::ClientAckGoodMove_Implementation(float TimeStamp)
+{
+	NetCounters.GoodMoveAcks++;
+	Super::ClientAckGoodMove_Implementation(TimeStamp);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// FSavedMove_Versatile
+
+FSavedMove_Versatile::FSavedMove_Versatile()
+{
+	CameraMode = ECharacterCameraMode::ThirdPersonDefault;
+	bUseControllerRotationYaw = false;
+	bOrientRotationToMovement = true;
+	DefaultAccelDotThresholdCombine = AccelDotThresholdCombine;
+}
+
+void FSavedMove_Versatile::Clear()
+{
+	Super::Clear();
+	
+	CameraMode = ECharacterCameraMode::ThirdPersonDefault;
+	bUseControllerRotationYaw = false;
+	bOrientRotationToMovement = true;
+	
+	// Moves are recycled through the free list, so a lowered threshold must not outlive the move it was set for
+	AccelDotThresholdCombine = DefaultAccelDotThresholdCombine;
+}
+
+void FSavedMove_Versatile::SetMoveFor(ACharacter* Character, float InDeltaTime, FVector const& NewAccel, FNetworkPredictionData_Client_Character& ClientData)
+{
+	Super::SetMoveFor(Character, InDeltaTime, NewAccel, ClientData);
+	
+	AVersatileCharacter* VersatileCharacter = Cast<AVersatileCharacter>(Character);
+	if (VersatileCharacter != nullptr)
+	{
+		CameraMode = VersatileCharacter->CameraModeEnum;
+	}
+	bUseControllerRotationYaw = Character->bUseControllerRotationYaw;
+	bOrientRotationToMovement = Character->GetCharacterMovement()->bOrientRotationToMovement;
+	
+	// Control rotation does not drive the simulation while rotation follows movement, so small changes
+	// in input direction can share a move
+	const UVersatileCharacterMovementComponent* MoveComp = Cast<UVersatileCharacterMovementComponent>(Character->GetCharacterMovement());
+	const bool bMovementDriven = (MoveComp != nullptr && bOrientRotationToMovement && !bUseControllerRotationYaw);
+	AccelDotThresholdCombine = bMovementDriven ? MoveComp->MovementDrivenAccelDotThresholdCombine : DefaultAccelDotThresholdCombine;
+}
+
+void FSavedMove_Versatile::PrepMoveFor(ACharacter* Character)
+{
+	Super::PrepMoveFor(Character);
+	
+	// Replay with the rotation settings the move was originally predicted with
+	Character->bUseControllerRotationYaw = bUseControllerRotationYaw;
+	Character->GetCharacterMovement()->bOrientRotationToMovement = bOrientRotationToMovement;
+}
+
+uint8 FSavedMove_Versatile::GetCompressedFlags() const
+{
+	uint8 Result = Super::GetCompressedFlags();
+	
+	// Rotation settings follow from the camera mode, so the mode is all the server needs
+	Result |= (CameraMode << UVersatileCharacterMovementComponent::CameraModeFlagShift) & UVersatileCharacterMovementComponent::CameraModeFlagMask;
+	return Result;
+}
+
+bool FSavedMove_Versatile::CanCombineWith(const FSavedMovePtr& NewMove, ACharacter* InCharacter, float MaxDelta) const
+{
+	const FSavedMove_Versatile* NewVersatileMove = static_cast<const FSavedMove_Versatile*>(NewMove.Get());
+	if (CameraMode != NewVersatileMove->CameraMode
+		|| bUseControllerRotationYaw != NewVersatileMove->bUseControllerRotationYaw
+		|| bOrientRotationToMovement != NewVersatileMove->bOrientRotationToMovement)
+	{
+		return false;
+	}
+	
+	return Super::CanCombineWith(NewMove, InCharacter, MaxDelta);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// FNetworkPredictionData_Client_Versatile
+
+FNetworkPredictionData_Client_Versatile::FNetworkPredictionData_Client_Versatile(const UCharacterMovementComponent& ClientMovement)
+	: Super(ClientMovement)
+{
+}
+
+FSavedMovePtr FNetworkPredictionData_Client_Versatile::AllocateNewMove()
+{
+	return FSavedMovePtr(new FSavedMove_Versatile());
+}
@@ -0,0 +1,107 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "GameFramework/CharacterMovementComponent.h"
+#include "VersatileCharacterMovementComponent.generated.h"
+
+/**
+ * Character movement that sends the owning client's camera mode with its saved moves.
+ * The server applies the same rotation settings the client predicted with (controller yaw in first
+ * person, orient to movement in the follow modes), and moves combine more readily while rotation
+ * follows movement, since control rotation then has no effect on the simulation.
+ */
+UCLASS()
+class VERSATILE_API UVersatileCharacterMovementComponent : public UCharacterMovementComponent
+{
+	GENERATED_BODY()
+
+public:
+	UVersatileCharacterMovementComponent();
+
+	/**
+	 * Minimum dot product between the acceleration directions of two moves for them to be combined
+	 * while rotation follows movement. Lower combines more. Other modes use the engine default.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Character Movement (Networking)", meta=(ClampMin="0.0", ClampMax="1.0"))
+	float MovementDrivenAccelDotThresholdCombine;
+
+	/** Move traffic seen by this component, for measuring bandwidth and correction rates */
+	struct FNetCounters
+	{
+		/** Server moves sent by the owning client */
+		uint32 MovesSent;
+
+		/** Server moves sent that carried a second, older move */
+		uint32 DualMovesSent;
+
+		/** Position corrections received from the server */
+		uint32 Corrections;
+
+		/** Good move acknowledgements received from the server */
+		uint32 GoodMoveAcks;
+
+		FNetCounters()
+			: MovesSent(0)
+			, DualMovesSent(0)
+			, Corrections(0)
+			, GoodMoveAcks(0)
+		{
+		}
+	};
+
+	const FNetCounters& GetNetCounters() const { return NetCounters; }
+	void ResetNetCounters() { NetCounters = FNetCounters(); }
+
+	/** Camera mode is sent in FLAG_Custom_0 and FLAG_Custom_1 of the compressed move flags */
+	static const uint8 CameraModeFlagShift = 4;
+	static const uint8 CameraModeFlagMask = 0x30;
+
+	// UCharacterMovementComponent interface
+	virtual FNetworkPredictionData_Client* GetPredictionData_Client() const override;
+	virtual void UpdateFromCompressedFlags(uint8 Flags) override;
+	virtual bool ClientUpdatePositionAfterServerUpdate() override;
+	virtual void CallServerMove(const FSavedMove_Character* NewMove, const FSavedMove_Character* OldMove) override;
+	virtual void ClientAdjustPosition_Implementation(float TimeStamp, FVector NewLoc, FVector NewVel, UPrimitiveComponent* NewBase, FName NewBaseBoneName, bool bHasBase, bool bBaseRelativePosition, uint8 ServerMovementMode) override;
+	virtual void ClientAckGoodMove_Implementation(float TimeStamp) override;
+	// End of UCharacterMovementComponent interface
+
+private:
+	FNetCounters NetCounters;
+
+};
+
+// MARK: - Saved Moves
+
+/** A saved move that also records the camera mode and rotation settings it was predicted with */
+class VERSATILE_API FSavedMove_Versatile : public FSavedMove_Character
+{
+public:
+	typedef FSavedMove_Character Super;
+
+	uint8 CameraMode;
+	bool bUseControllerRotationYaw;
+	bool bOrientRotationToMovement;
+
+	/** The engine's combine threshold, restored when a move is reused in a mode that is not movement driven */
+	float DefaultAccelDotThresholdCombine;
+
+	FSavedMove_Versatile();
+
+	virtual void Clear() override;
+	virtual void SetMoveFor(ACharacter* Character, float InDeltaTime, FVector const& NewAccel, FNetworkPredictionData_Client_Character& ClientData) override;
+	virtual void PrepMoveFor(ACharacter* Character) override;
+	virtual uint8 GetCompressedFlags() const override;
+	virtual bool CanCombineWith(const FSavedMovePtr& NewMove, ACharacter* InCharacter, float MaxDelta) const override;
+};
+
+/** Client prediction data that allocates FSavedMove_Versatile */
+class VERSATILE_API FNetworkPredictionData_Client_Versatile : public FNetworkPredictionData_Client_Character
+{
+public:
+	typedef FNetworkPredictionData_Client_Character Super;
+
+	FNetworkPredictionData_Client_Versatile(const UCharacterMovementComponent& ClientMovement);
+
+	virtual FSavedMovePtr AllocateNewMove() override;
+};
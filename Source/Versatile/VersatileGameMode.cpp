@@ -4,6 +4,7 @@
 #include "VersatileGameMode.h"
 #include "VersatileHUD.h"
 #include "VersatileCharacter.h"
+#include "VersatileLightweightCharacter.h"
 #include "VersatilePlayerController.h"
 AVersatileGameMode::AVersatileGameMode()
 {
@@ -18,4 +19,33 @@ AVersatileGameMode::AVersatileGameMode()
 		
 		HUDClass = AVersatileHUD::StaticClass();
 	}
+	
+	bSpawnLightweightPlayerPawns = false;
+}
+
+APawn* AVersatileGameMode::SpawnDefaultPawnFor_Implementation(AController* NewPlayer, AActor* StartSpot)
+{
+	UClass* PawnClass = GetDefaultPawnClassForController(NewPlayer);
+	const bool bFullCharacterClass = PawnClass != nullptr && PawnClass->IsChildOf(AVersatileCharacter::StaticClass()) && !PawnClass->IsChildOf(AVersatileLightweightCharacter::StaticClass());
+	if (!bSpawnLightweightPlayerPawns || !bFullCharacterClass || StartSpot == nullptr)
+	{
+		return Super::SpawnDefaultPawnFor_Implementation(NewPlayer, StartSpot);
+	}
+	
+	// Placed the way the default implementation places pawns
+	FRotator StartRotation(ForceInit);
+	StartRotation.Yaw = StartSpot->GetActorRotation().Yaw;
+	const FTransform SpawnTransform(StartRotation, StartSpot->GetActorLocation());
+	
+	// Transient like the default implementation's pawns, so they are never saved with the level
+	FActorSpawnParameters SpawnInfo;
+	SpawnInfo.Instigator = Instigator;
+	SpawnInfo.ObjectFlags |= RF_Transient;
+	SpawnInfo.bDeferConstruction = true;
+	AVersatileLightweightCharacter* Character = GetWorld()->SpawnActor<AVersatileLightweightCharacter>(AVersatileLightweightCharacter::StaticClass(), SpawnTransform, SpawnInfo);
+	if (Character == nullptr) return nullptr;
+	
+	Character->InitFromTemplate(PawnClass);
+	Character->FinishSpawning(SpawnTransform);
+	return Character;
 }
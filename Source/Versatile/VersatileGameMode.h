@@ -10,6 +10,16 @@ class AVersatileGameMode : public AGameModeBase
 
 public:
 	AVersatileGameMode();
+	
+	/**
+	 * Whether players whose default pawn is a full Versatile character class get a lightweight character
+	 * set up from that class instead, so respawning reuses the camera rig pooled on their controller.
+	 * The class is replicated so clients set the character up the same way. Off by default.
+	 */
+	UPROPERTY(EditDefaultsOnly, Category=Classes)
+	bool bSpawnLightweightPlayerPawns;
+	
+	virtual APawn* SpawnDefaultPawnFor_Implementation(AController* NewPlayer, AActor* StartSpot) override;
 };
 
 
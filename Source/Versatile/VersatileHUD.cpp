@@ -2,33 +2,189 @@
 
 #include "Versatile.h"
 #include "VersatileHUD.h"
+#include "VersatileSignificanceManager.h"
+#include "VersatileMirror.h"
 #include "Engine/Canvas.h"
 #include "TextureResource.h"
 #include "CanvasItem.h"
 
+/** Number of overlay text lines the panel is sized for */
+static const int32 OverlayLineCount = 4;
+
 AVersatileHUD::AVersatileHUD()
 {
 	// Set the crosshair texture
 	static ConstructorHelpers::FObjectFinder<UTexture2D> CrosshiarTexObj(TEXT("/Game/Textures/FirstPersonCrosshair"));
 	CrosshairTex = CrosshiarTexObj.Object;
+	
+	OverShoulderCrosshairOffset = FVector2D(0.f, -.05f);
+	CrosshairScale = 1.f;
+	bShowPerfOverlay = false;
+	PerfOverlayRefreshInterval = .5f;
+	
+	BuiltCameraMode = ECharacterCameraMode::Max;
+	BuiltViewportSize = FIntPoint::ZeroValue;
+	bBuiltWithOverlay = false;
+	bGeometryValid = false;
+	
+	FMemory::Memzero(FrameTimeSamples, sizeof(FrameTimeSamples));
+	NextFrameTimeSample = 0;
+	NumFrameTimeSamples = 0;
+	TimeSinceOverlayRefresh = 0.f;
+	OverlayOrigin = FVector2D::ZeroVector;
+	OverlayLineHeight = 14.f;
 }
 
+void AVersatileHUD::VersatilePerfOverlay()
+{
+	bShowPerfOverlay = !bShowPerfOverlay;
+	TimeSinceOverlayRefresh = PerfOverlayRefreshInterval;
+}
 
 void AVersatileHUD::DrawHUD()
 {
 	Super::DrawHUD();
 	
-	// Draw very simple crosshair
-	
-//	// find center of the Canvas
-//	const FVector2D Center(Canvas->ClipX * 0.5f, Canvas->ClipY * 0.5f);
-//	
-//	// offset by half the texture's dimensions so that the center of the texture aligns with the center of the Canvas
-//	const FVector2D CrosshairDrawPosition( (Center.X),
-//										   (Center.Y + 20.0f));
-//	
-//	// draw the crosshair
-//	FCanvasTileItem TileItem( CrosshairDrawPosition, CrosshairTex->Resource, FLinearColor::White);
-//	TileItem.BlendMode = SE_BLEND_Translucent;
-//	Canvas->DrawItem( TileItem );
+	const AVersatileCharacter* Character = Cast<AVersatileCharacter>(GetOwningPawn());
+	const ECharacterCameraMode::Type CameraMode = Character ? Character->CameraModeEnum.GetValue() : ECharacterCameraMode::ThirdPersonDefault;
+	const FIntPoint ViewportSize(Canvas->SizeX, Canvas->SizeY);
+	
+	if (!bGeometryValid || CameraMode != BuiltCameraMode || ViewportSize != BuiltViewportSize || bShowPerfOverlay != bBuiltWithOverlay)
+	{
+		RebuildGeometry(CameraMode, ViewportSize);
+	}
+	
+	// Everything below goes through the canvas batcher in one pass: one triangle item per texture, then text
+	if (CrosshairTriangles.Num() > 0 && CrosshairTex != nullptr)
+	{
+		FCanvasTriangleItem CrosshairItem(CrosshairTriangles, CrosshairTex->Resource);
+		CrosshairItem.BlendMode = SE_BLEND_Translucent;
+		Canvas->DrawItem(CrosshairItem);
+	}
+	
+	if (!bShowPerfOverlay) return;
+	
+	const float FrameTime = FApp::GetDeltaTime() * 1000.f;
+	FrameTimeSamples[NextFrameTimeSample] = FrameTime;
+	NextFrameTimeSample = (NextFrameTimeSample + 1) % FrameTimeSampleCount;
+	NumFrameTimeSamples = FMath::Min(NumFrameTimeSamples + 1, FrameTimeSampleCount);
+	
+	TimeSinceOverlayRefresh += FApp::GetDeltaTime();
+	if (TimeSinceOverlayRefresh >= PerfOverlayRefreshInterval || OverlayLines.Num() == 0)
+	{
+		TimeSinceOverlayRefresh = 0.f;
+		RefreshOverlayText(Character);
+	}
+	
+	FCanvasTriangleItem PanelItem(OverlayTriangles, GWhiteTexture);
+	PanelItem.BlendMode = SE_BLEND_Translucent;
+	Canvas->DrawItem(PanelItem);
+	
+	FCanvasTextItem TextItem(FVector2D::ZeroVector, FText::GetEmpty(), GEngine->GetSmallFont(), FLinearColor::White);
+	for (int32 Line = 0; Line < OverlayLines.Num(); Line++)
+	{
+		TextItem.Text = FText::FromString(OverlayLines[Line]);
+		Canvas->DrawItem(TextItem, OverlayOrigin + FVector2D(6.f, 4.f + Line * OverlayLineHeight));
+	}
+}
+
+// MARK: - Retained Geometry
+
+void AVersatileHUD::AddQuad(TArray<FCanvasUVTri>& Triangles, const FVector2D& Position, const FVector2D& Size, const FLinearColor& Color)
+{
+	const FVector2D TopRight(Position.X + Size.X, Position.Y);
+	const FVector2D BottomLeft(Position.X, Position.Y + Size.Y);
+	const FVector2D BottomRight = Position + Size;
+	
+	FCanvasUVTri& Upper = Triangles[Triangles.AddUninitialized()];
+	Upper.V0_Pos = Position;		Upper.V0_UV = FVector2D(0.f, 0.f);	Upper.V0_Color = Color;
+	Upper.V1_Pos = TopRight;		Upper.V1_UV = FVector2D(1.f, 0.f);	Upper.V1_Color = Color;
+	Upper.V2_Pos = BottomRight;		Upper.V2_UV = FVector2D(1.f, 1.f);	Upper.V2_Color = Color;
+	
+	FCanvasUVTri& Lower = Triangles[Triangles.AddUninitialized()];
+	Lower.V0_Pos = Position;		Lower.V0_UV = FVector2D(0.f, 0.f);	Lower.V0_Color = Color;
+	Lower.V1_Pos = BottomRight;		Lower.V1_UV = FVector2D(1.f, 1.f);	Lower.V1_Color = Color;
+	Lower.V2_Pos = BottomLeft;		Lower.V2_UV = FVector2D(0.f, 1.f);	Lower.V2_Color = Color;
+}
+
+void AVersatileHUD::RebuildGeometry(ECharacterCameraMode::Type CameraMode, const FIntPoint& ViewportSize)
+{
+	CrosshairTriangles.Reset();
+	OverlayTriangles.Reset();
+	
+	const FVector2D Viewport(ViewportSize.X, ViewportSize.Y);
+	const FVector2D Center = Viewport * .5f;
+	
+	// First person aims from the center, over shoulder from an offset point, and the follow cameras don't aim
+	bool bHasCrosshair = false;
+	FVector2D CrosshairCenter = Center;
+	switch (CameraMode)
+	{
+		case ECharacterCameraMode::FirstPerson:
+			bHasCrosshair = true;
+			break;
+		case ECharacterCameraMode::ThirdPersonOverShoulder:
+			bHasCrosshair = true;
+			CrosshairCenter += OverShoulderCrosshairOffset * Viewport;
+			break;
+		default:
+			break;
+	}
+	
+	if (bHasCrosshair && CrosshairTex != nullptr)
+	{
+		// Offset by half the texture's dimensions so that the center of the texture aligns with the aim point
+		const FVector2D CrosshairSize = FVector2D(CrosshairTex->GetSurfaceWidth(), CrosshairTex->GetSurfaceHeight()) * CrosshairScale;
+		AddQuad(CrosshairTriangles, CrosshairCenter - CrosshairSize * .5f, CrosshairSize, FLinearColor::White);
+	}
+	
+	if (bShowPerfOverlay)
+	{
+		const FVector2D PanelSize(340.f, 8.f + OverlayLineCount * OverlayLineHeight);
+		OverlayOrigin = FVector2D(Viewport.X - PanelSize.X - 16.f, 16.f);
+		AddQuad(OverlayTriangles, OverlayOrigin, PanelSize, FLinearColor(0.f, 0.f, 0.f, .5f));
+	}
+	
+	BuiltCameraMode = CameraMode;
+	BuiltViewportSize = ViewportSize;
+	bBuiltWithOverlay = bShowPerfOverlay;
+	bGeometryValid = true;
+}
+
+// MARK: - Perf Overlay
+
+void AVersatileHUD::RefreshOverlayText(const AVersatileCharacter* Character)
+{
+	OverlayLines.Reset(OverlayLineCount);
+	
+	// Frame time percentiles over the ring buffer
+	float Sorted[FrameTimeSampleCount];
+	FMemory::Memcpy(Sorted, FrameTimeSamples, NumFrameTimeSamples * sizeof(float));
+	Sort(Sorted, NumFrameTimeSamples);
+	auto Percentile = [&Sorted, this](float Fraction) { return NumFrameTimeSamples > 0 ? Sorted[FMath::Min(FMath::FloorToInt(Fraction * NumFrameTimeSamples), NumFrameTimeSamples - 1)] : 0.f; };
+	OverlayLines.Add(FString::Printf(TEXT("Frame ms  p50 %.2f  p95 %.2f  p99 %.2f  max %.2f"), Percentile(.5f), Percentile(.95f), Percentile(.99f), Percentile(1.f)));
+	
+	if (Character != nullptr)
+	{
+		OverlayLines.Add(FString::Printf(TEXT("Camera  %s"), *GetNameForCameraMode(Character->CameraModeEnum)));
+	}
+	else
+	{
+		OverlayLines.Add(TEXT("Camera  -"));
+	}
+	
+	const AVersatileSignificanceManager* SignificanceManager = AVersatileSignificanceManager::Find(GetWorld());
+	if (SignificanceManager != nullptr)
+	{
+		OverlayLines.Add(FString::Printf(TEXT("Significance  viewed %d  near %d  mid %d  far %d  hidden %d"),
+			SignificanceManager->GetTierCount(EVersatileSignificanceTier::Viewed),
+			SignificanceManager->GetTierCount(EVersatileSignificanceTier::Near),
+			SignificanceManager->GetTierCount(EVersatileSignificanceTier::Mid),
+			SignificanceManager->GetTierCount(EVersatileSignificanceTier::Far),
+			SignificanceManager->GetTierCount(EVersatileSignificanceTier::Hidden)));
+	}
+	
+	const FVersatileMirrorFrameStats& MirrorStats = AVersatileMirror::GetLastFrameStats();
+	OverlayLines.Add(FString::Printf(TEXT("Mirror captures %d  skipped offscreen %d  over budget %d"),
+		MirrorStats.Captures, MirrorStats.SkippedOffscreen, MirrorStats.SkippedBudget));
 }
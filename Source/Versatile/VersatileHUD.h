@@ -3,10 +3,14 @@
 #pragma once
 
 #include "GameFramework/HUD.h"
+#include "CanvasTypes.h"
+#include "VersatileCharacter.h"
 #include "VersatileHUD.generated.h"
 
 /**
- * 
+ * Draws the crosshair for the owning character's camera mode and an optional performance overlay.
+ * Crosshair and overlay panel geometry is kept between frames and only rebuilt when the camera mode,
+ * viewport size or overlay visibility changes; overlay text is refreshed a few times a second.
  */
 UCLASS()
 class VERSATILE_API AVersatileHUD : public AHUD
@@ -17,9 +21,60 @@ public:
 	AVersatileHUD();
 	virtual void DrawHUD() override;
 	
+	/** Crosshair offset from the viewport center in over shoulder mode, as a fraction of the viewport size */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category=Crosshair)
+	FVector2D OverShoulderCrosshairOffset;
+	
+	/** Crosshair size multiplier */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category=Crosshair)
+	float CrosshairScale;
+	
+	/** Whether the performance overlay is shown */
+	UPROPERTY(config, EditAnywhere, BlueprintReadWrite, Category=PerfOverlay)
+	bool bShowPerfOverlay;
+	
+	/** Seconds between refreshes of the performance overlay text */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category=PerfOverlay)
+	float PerfOverlayRefreshInterval;
+	
+	/** Toggles the performance overlay */
+	UFUNCTION(exec)
+	void VersatilePerfOverlay();
+	
 private:
 	/** Crosshair asset pointer */
 	class UTexture2D* CrosshairTex;
 	
+	/** Retained crosshair geometry, empty in modes without a crosshair */
+	TArray<FCanvasUVTri> CrosshairTriangles;
+	
+	/** Retained overlay panel geometry */
+	TArray<FCanvasUVTri> OverlayTriangles;
+	
+	/** What the retained geometry was built for */
+	ECharacterCameraMode::Type BuiltCameraMode;
+	FIntPoint BuiltViewportSize;
+	bool bBuiltWithOverlay;
+	bool bGeometryValid;
+	
+	/** Ring buffer of recent frame times in milliseconds */
+	static const int32 FrameTimeSampleCount = 128;
+	float FrameTimeSamples[FrameTimeSampleCount];
+	int32 NextFrameTimeSample;
+	int32 NumFrameTimeSamples;
+	
+	/** Overlay text as of the last refresh */
+	TArray<FString> OverlayLines;
+	float TimeSinceOverlayRefresh;
+	
+	/** Top left of the overlay panel and its line height */
+	FVector2D OverlayOrigin;
+	float OverlayLineHeight;
+	
+	void RebuildGeometry(ECharacterCameraMode::Type CameraMode, const FIntPoint& ViewportSize);
+	void RefreshOverlayText(const class AVersatileCharacter* Character);
+	
+	/** Appends two triangles covering a rectangle */
+	static void AddQuad(TArray<FCanvasUVTri>& Triangles, const FVector2D& Position, const FVector2D& Size, const FLinearColor& Color);
 	
 };
@@ -0,0 +1,105 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Versatile.h"
+#include "VersatileLightweightCharacter.h"
+#include "Components/CapsuleComponent.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "UnrealNetwork.h"
+
+AVersatileLightweightCharacter::AVersatileLightweightCharacter(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer
+		.DoNotCreateDefaultSubobject(AVersatileCharacter::CameraBoomName)
+		.DoNotCreateDefaultSubobject(AVersatileCharacter::FollowCameraName)
+		.DoNotCreateDefaultSubobject(AVersatileCharacter::FirstPersonCameraName)
+		.DoNotCreateDefaultSubobject(AVersatileCharacter::ArmsMeshName)
+		.DoNotCreateDefaultSubobject(AVersatileCharacter::BodyMeshName)
+		.DoNotCreateDefaultSubobject(AVersatileCharacter::OverShoulderCameraBoomName)
+		.DoNotCreateDefaultSubobject(AVersatileCharacter::OverShoulderCameraName))
+{
+	// Camera logic is the only thing AVersatileCharacter ticks for, so wait until there is a camera
+	PrimaryActorTick.bStartWithTickEnabled = false;
+}
+
+/**
+ * Copies the property values class defaults can override, leaving component references and tick
+ * functions alone.
+ */
+static void CopyEditableProperties(UObject* Target, const UObject* Source, UClass* PropertyClass, EFieldIteratorFlags::SuperClassFlags SuperClassFlags)
+{
+	for (TFieldIterator<UProperty> It(PropertyClass, SuperClassFlags); It; ++It)
+	{
+		UProperty* Property = *It;
+		if (!Property->HasAnyPropertyFlags(CPF_Edit) || Property->HasAnyPropertyFlags(CPF_EditConst | CPF_Transient | CPF_InstancedReference | CPF_ContainsInstancedReference)) continue;
+		
+		const UStructProperty* StructProperty = Cast<UStructProperty>(Property);
+		if (StructProperty != nullptr && StructProperty->Struct->IsChildOf(FTickFunction::StaticStruct())) continue;
+		
+		Property->CopyCompleteValue_InContainer(Target, Source);
+	}
+}
+
+void AVersatileLightweightCharacter::InitFromTemplate(TSubclassOf<AVersatileCharacter> InTemplateClass)
+{
+	TemplateClass = InTemplateClass;
+	ApplyTemplate();
+}
+
+void AVersatileLightweightCharacter::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+	
+	DOREPLIFETIME_CONDITION(AVersatileLightweightCharacter, TemplateClass, COND_InitialOnly);
+}
+
+void AVersatileLightweightCharacter::OnRep_TemplateClass()
+{
+	ApplyTemplate();
+}
+
+void AVersatileLightweightCharacter::ApplyTemplate()
+{
+	const AVersatileCharacter* Template = TemplateClass ? TemplateClass->GetDefaultObject<AVersatileCharacter>() : nullptr;
+	if (Template == nullptr) return;
+	
+	// Camera tuning declared on AVersatileCharacter; engine actor settings stay as this class has them
+	CopyEditableProperties(this, Template, AVersatileCharacter::StaticClass(), EFieldIteratorFlags::ExcludeSuper);
+	ViewComponentTemplateClass = TemplateClass;
+	
+	// Mesh, animation, collision size and movement tuning. On clients the class arrives after the components
+	// registered, so they are registered again to pick up the new mesh, anim class and capsule size
+	USkeletalMeshComponent* MeshComponent = GetMesh();
+	if (MeshComponent != nullptr && Template->GetMesh() != nullptr && MeshComponent->GetClass() == Template->GetMesh()->GetClass())
+	{
+		CopyEditableProperties(MeshComponent, Template->GetMesh(), MeshComponent->GetClass(), EFieldIteratorFlags::IncludeSuper);
+		if (MeshComponent->IsRegistered())
+		{
+			MeshComponent->ReregisterComponent();
+			MeshComponent->UpdateComponentToWorld();
+			
+			// ACharacter cached the mesh offset in PostInitializeComponents; network smoothing restores to it
+			BaseTranslationOffset = MeshComponent->RelativeLocation;
+			BaseRotationOffset = MeshComponent->RelativeRotation.Quaternion();
+		}
+	}
+	UCapsuleComponent* Capsule = GetCapsuleComponent();
+	if (Capsule != nullptr && Template->GetCapsuleComponent() != nullptr)
+	{
+		// The capsule is the root, so its relative transform is where this character stands
+		const FVector Location = Capsule->RelativeLocation;
+		const FRotator Rotation = Capsule->RelativeRotation;
+		const FVector Scale = Capsule->RelativeScale3D;
+		CopyEditableProperties(Capsule, Template->GetCapsuleComponent(), UCapsuleComponent::StaticClass(), EFieldIteratorFlags::IncludeSuper);
+		Capsule->RelativeLocation = Location;
+		Capsule->RelativeRotation = Rotation;
+		Capsule->RelativeScale3D = Scale;
+		
+		if (Capsule->IsRegistered())
+		{
+			Capsule->ReregisterComponent();
+		}
+	}
+	if (GetCharacterMovement() != nullptr && Template->GetCharacterMovement() != nullptr && GetCharacterMovement()->GetClass() == Template->GetCharacterMovement()->GetClass())
+	{
+		CopyEditableProperties(GetCharacterMovement(), Template->GetCharacterMovement(), GetCharacterMovement()->GetClass(), EFieldIteratorFlags::IncludeSuper);
+	}
+}
@@ -0,0 +1,43 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "VersatileCharacter.h"
+#include "VersatileLightweightCharacter.generated.h"
+
+/**
+ * Versatile character that skips its camera and first person components at construction.
+ * They are created when a local player possesses it and destroyed again on unpossession,
+ * which keeps AI and background characters cheap to spawn.
+ */
+UCLASS(config=Game)
+class VERSATILE_API AVersatileLightweightCharacter : public AVersatileCharacter
+{
+	GENERATED_BODY()
+	
+public:
+	AVersatileLightweightCharacter(const FObjectInitializer& ObjectInitializer);
+	
+	/**
+	 * Sets this character up as a stand-in for a full character class: takes its tuning and the defaults of
+	 * its third person mesh, capsule and movement, and uses it as ViewComponentTemplateClass.
+	 * Call on the server between SpawnActorDeferred and FinishSpawning; clients repeat it when the class replicates.
+	 * @param InTemplateClass	The full character class, usually a Blueprint
+	 */
+	void InitFromTemplate(TSubclassOf<AVersatileCharacter> InTemplateClass);
+	
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+	
+protected:
+	/** Full character class this character stands in for, if any. Sent once so clients match the server's setup */
+	UPROPERTY(ReplicatedUsing=OnRep_TemplateClass)
+	TSubclassOf<AVersatileCharacter> TemplateClass;
+	
+	UFUNCTION()
+	void OnRep_TemplateClass();
+	
+private:
+	/** Copies TemplateClass defaults onto this character, re-registering any components that already are */
+	void ApplyTemplate();
+	
+};
@@ -0,0 +1,261 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Versatile.h"
+#include "VersatileMirror.h"
+#include "VersatileCharacter.h"
+#include "Components/SceneCaptureComponent2D.h"
+#include "Engine/TextureRenderTarget2D.h"
+#include "Engine.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Mirror Captures"), STAT_VersatileMirrorCaptures, STATGROUP_Versatile);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Mirror Skipped Offscreen"), STAT_VersatileMirrorSkippedOffscreen, STATGROUP_Versatile);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Mirror Skipped Budget"), STAT_VersatileMirrorSkippedBudget, STATGROUP_Versatile);
+
+static TAutoConsoleVariable<int32> CVarVersatileMirrorMaxCapturesPerFrame(
+	TEXT("versatile.Mirror.MaxCapturesPerFrame"),
+	1,
+	TEXT("Most mirror reflection captures rendered in one frame across all mirrors. Others wait for a later frame."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarVersatileMirrorForceVisible(
+	TEXT("versatile.Mirror.ForceVisible"),
+	0,
+	TEXT("Treat every mirror as on screen. Lets headless runs without a renderer exercise the capture budget."),
+	ECVF_Default);
+
+// MARK: - Frame Stats
+
+static FVersatileMirrorFrameStats GMirrorCurrentFrameStats;
+static FVersatileMirrorFrameStats GMirrorLastFrameStats;
+static uint64 GMirrorStatsFrame = 0;
+static uint64 GMirrorTotalCaptures = 0;
+
+/** Rolls the current counts over to the last frame when a new frame starts */
+static FVersatileMirrorFrameStats& GetMirrorStatsForThisFrame()
+{
+	if (GMirrorStatsFrame != GFrameCounter)
+	{
+		GMirrorLastFrameStats = (GMirrorStatsFrame + 1 == GFrameCounter) ? GMirrorCurrentFrameStats : FVersatileMirrorFrameStats();
+		GMirrorCurrentFrameStats = FVersatileMirrorFrameStats();
+		GMirrorStatsFrame = GFrameCounter;
+	}
+	return GMirrorCurrentFrameStats;
+}
+
+const FVersatileMirrorFrameStats& AVersatileMirror::GetCurrentFrameStats()
+{
+	return GetMirrorStatsForThisFrame();
+}
+
+const FVersatileMirrorFrameStats& AVersatileMirror::GetLastFrameStats()
+{
+	GetMirrorStatsForThisFrame();
+	return GMirrorLastFrameStats;
+}
+
+uint64 AVersatileMirror::GetTotalCaptures()
+{
+	return GMirrorTotalCaptures;
+}
+
+/** Every mirror in play, across all worlds */
+static TArray<AVersatileMirror*> GMirrors;
+
+//////////////////////////////////////////////////////////////////////////
+// AVersatileMirror
+
+AVersatileMirror::AVersatileMirror()
+{
+	PrimaryActorTick.bCanEverTick = true;
+
+	// Capture after cameras have been updated so the reflection matches this frame's view
+	PrimaryActorTick.TickGroup = TG_PostUpdateWork;
+
+	MirrorMesh = CreateDefaultSubobject<UStaticMeshComponent>(TEXT("MirrorMesh"));
+	RootComponent = MirrorMesh;
+
+	MirrorCapture = CreateDefaultSubobject<USceneCaptureComponent2D>(TEXT("MirrorCapture"));
+	MirrorCapture->SetupAttachment(MirrorMesh);
+	MirrorCapture->bCaptureEveryFrame = false;
+	MirrorCapture->bCaptureOnMovement = false;
+	MirrorCapture->bEnableClipPlane = true;
+	MirrorCapture->CaptureSource = SCS_FinalColorLDR;
+
+	ReflectionTextureParameterName = TEXT("ReflectionTexture");
+	ResolutionScale = .5f;
+	UpdateRate = 30.f;
+	LODDistanceFactor = 2.f;
+	MaxViewDistance = 0.f;
+	bCaptureDynamicShadows = false;
+
+	RenderTarget = nullptr;
+	MirrorMaterial = nullptr;
+	TimeSinceCapture = 0.f;
+	LastScheduledFrame = 0;
+}
+
+void AVersatileMirror::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
+
+	if (MirrorMesh->GetMaterial(0) != nullptr)
+	{
+		MirrorMaterial = MirrorMesh->CreateAndSetMaterialInstanceDynamic(0);
+	}
+}
+
+void AVersatileMirror::BeginPlay()
+{
+	Super::BeginPlay();
+	GMirrors.Add(this);
+}
+
+void AVersatileMirror::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	GMirrors.RemoveSingleSwap(this);
+	Super::EndPlay(EndPlayReason);
+}
+
+// MARK: - Tick
+
+void AVersatileMirror::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	// The first mirror to tick each frame schedules every mirror in its world
+	if (LastScheduledFrame != GFrameCounter)
+	{
+		ScheduleCaptures(DeltaSeconds);
+	}
+}
+
+void AVersatileMirror::ScheduleCaptures(float DeltaSeconds)
+{
+	UWorld* World = GetWorld();
+
+	// Reflect a local viewer only; a server has no business rendering a remote client's view
+	APlayerController* PlayerController = GEngine->GetFirstLocalPlayerController(World);
+	APlayerCameraManager* CameraManager = PlayerController ? PlayerController->PlayerCameraManager : nullptr;
+
+	FVersatileMirrorFrameStats& FrameStats = GetMirrorStatsForThisFrame();
+	TArray<AVersatileMirror*, TInlineAllocator<16>> DueMirrors;
+	for (AVersatileMirror* Mirror : GMirrors)
+	{
+		if (Mirror->GetWorld() != World) continue;
+
+		Mirror->LastScheduledFrame = GFrameCounter;
+		Mirror->TimeSinceCapture += DeltaSeconds;
+		if (CameraManager == nullptr || Mirror->TimeSinceCapture < 1.f / FMath::Max(Mirror->UpdateRate, 1.f)) continue;
+
+		if (!Mirror->IsVisibleFrom(CameraManager->GetCameraLocation()))
+		{
+			FrameStats.SkippedOffscreen++;
+			INC_DWORD_STAT(STAT_VersatileMirrorSkippedOffscreen);
+			continue;
+		}
+		DueMirrors.Add(Mirror);
+	}
+
+	// Longest waiting first, so a mirror held back by the budget climbs the queue until it is served
+	DueMirrors.Sort([](const AVersatileMirror& A, const AVersatileMirror& B) { return A.TimeSinceCapture > B.TimeSinceCapture; });
+
+	const int32 MaxCaptures = CVarVersatileMirrorMaxCapturesPerFrame.GetValueOnGameThread();
+	for (AVersatileMirror* Mirror : DueMirrors)
+	{
+		if (FrameStats.Captures >= MaxCaptures)
+		{
+			FrameStats.SkippedBudget++;
+			INC_DWORD_STAT(STAT_VersatileMirrorSkippedBudget);
+			continue;
+		}
+
+		Mirror->CaptureReflection(CameraManager);
+		Mirror->TimeSinceCapture = 0.f;
+
+		FrameStats.Captures++;
+		GMirrorTotalCaptures++;
+		INC_DWORD_STAT(STAT_VersatileMirrorCaptures);
+	}
+}
+
+bool AVersatileMirror::IsVisibleFrom(const FVector& ViewLocation) const
+{
+	const FVector PlaneNormal = MirrorMesh->GetUpVector();
+	const bool bFacingViewer = FVector::DotProduct(ViewLocation - MirrorMesh->GetComponentLocation(), PlaneNormal) > 0.f;
+	if (!bFacingViewer) return false;
+
+	if (CVarVersatileMirrorForceVisible.GetValueOnGameThread() != 0) return true;
+
+	return WasRecentlyRendered(.1f);
+}
+
+// MARK: - Capture
+
+void AVersatileMirror::UpdateRenderTarget()
+{
+	FVector2D ViewportSize(1280.f, 720.f);
+	if (GEngine != nullptr && GEngine->GameViewport != nullptr)
+	{
+		GEngine->GameViewport->GetViewportSize(ViewportSize);
+	}
+
+	const int32 Width = FMath::Max(FMath::RoundToInt(ViewportSize.X * ResolutionScale), 16);
+	const int32 Height = FMath::Max(FMath::RoundToInt(ViewportSize.Y * ResolutionScale), 16);
+
+	if (RenderTarget == nullptr)
+	{
+		RenderTarget = NewObject<UTextureRenderTarget2D>(this);
+		RenderTarget->ClearColor = FLinearColor::Black;
+	}
+	else if (RenderTarget->SizeX == Width && RenderTarget->SizeY == Height)
+	{
+		return;
+	}
+
+	RenderTarget->InitAutoFormat(Width, Height);
+	MirrorCapture->TextureTarget = RenderTarget;
+
+	if (MirrorMaterial != nullptr)
+	{
+		MirrorMaterial->SetTextureParameterValue(ReflectionTextureParameterName, RenderTarget);
+	}
+}
+
+void AVersatileMirror::CaptureReflection(const APlayerCameraManager* CameraManager)
+{
+	UpdateRenderTarget();
+
+	const FVector PlaneBase = MirrorMesh->GetComponentLocation();
+	const FVector PlaneNormal = MirrorMesh->GetUpVector();
+
+	// Reflect the viewer's position and orientation through the mirror plane
+	const FVector ViewLocation = CameraManager->GetCameraLocation();
+	const FRotationMatrix ViewAxes(CameraManager->GetCameraRotation());
+	const FVector ViewForward = ViewAxes.GetUnitAxis(EAxis::X);
+	const FVector ViewUp = ViewAxes.GetUnitAxis(EAxis::Z);
+
+	const FVector ReflectedLocation = ViewLocation - 2.f * FVector::DotProduct(ViewLocation - PlaneBase, PlaneNormal) * PlaneNormal;
+	const FVector ReflectedForward = ViewForward - 2.f * FVector::DotProduct(ViewForward, PlaneNormal) * PlaneNormal;
+	const FVector ReflectedUp = ViewUp - 2.f * FVector::DotProduct(ViewUp, PlaneNormal) * PlaneNormal;
+
+	MirrorCapture->SetWorldLocationAndRotation(ReflectedLocation, FRotationMatrix::MakeFromXZ(ReflectedForward, ReflectedUp).Rotator());
+	MirrorCapture->FOVAngle = CameraManager->GetFOVAngle();
+	MirrorCapture->ClipPlaneBase = PlaneBase;
+	MirrorCapture->ClipPlaneNormal = PlaneNormal;
+	MirrorCapture->LODDistanceFactor = LODDistanceFactor;
+	MirrorCapture->MaxViewDistanceOverride = (MaxViewDistance > 0.f) ? MaxViewDistance : -1.f;
+	MirrorCapture->ShowFlags.SetDynamicShadows(bCaptureDynamicShadows);
+
+	// Characters being looked through show their third person mesh in the reflection
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		APlayerController* PlayerController = *It;
+		AVersatileCharacter* Character = PlayerController ? Cast<AVersatileCharacter>(PlayerController->GetViewTarget()) : nullptr;
+		if (Character != nullptr && PlayerController->IsLocalController())
+		{
+			Character->PrepareMirrorCapture(MirrorCapture);
+		}
+	}
+
+	MirrorCapture->CaptureScene();
+}
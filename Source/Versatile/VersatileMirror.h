@@ -0,0 +1,118 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "GameFramework/Actor.h"
+#include "VersatileMirror.generated.h"
+
+/**
+ * Reflection capture counts across every mirror in the process.
+ * Updated even without a renderer, so headless runs can check the budget through them.
+ */
+struct FVersatileMirrorFrameStats
+{
+	/** Captures issued during the frame */
+	int32 Captures;
+
+	/** Mirrors that were due for an update but off screen or facing away */
+	int32 SkippedOffscreen;
+
+	/** Mirrors that were due for an update but over the per-frame capture budget */
+	int32 SkippedBudget;
+
+	FVersatileMirrorFrameStats()
+		: Captures(0)
+		, SkippedOffscreen(0)
+		, SkippedBudget(0)
+	{
+	}
+};
+
+/**
+ * A mirror that renders its reflection with a scene capture at reduced resolution and update rate.
+ * Mirrors that are due share a per-frame capture budget, longest waiting first.
+ * The capture is mirrored from the first local player's camera and clipped to the mirror plane
+ * (which needs r.AllowGlobalClipPlane). The result is passed to the mirror material as a texture parameter.
+ * The mirror plane is the mesh's local XY plane, reflecting along its up vector.
+ */
+UCLASS(config=Game)
+class VERSATILE_API AVersatileMirror : public AActor
+{
+	GENERATED_BODY()
+
+	/** The mirror surface */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category=Mirror, meta=(AllowPrivateAccess="true"))
+	class UStaticMeshComponent* MirrorMesh;
+
+	/** Capture that renders the reflection */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category=Mirror, meta=(AllowPrivateAccess="true"))
+	class USceneCaptureComponent2D* MirrorCapture;
+
+public:
+	AVersatileMirror();
+
+	/** Texture parameter on the mirror material that receives the reflection */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=Mirror)
+	FName ReflectionTextureParameterName;
+
+	/** Reflection resolution as a fraction of the viewport size */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=MirrorBudget, meta=(ClampMin="0.1", ClampMax="1.0"))
+	float ResolutionScale;
+
+	/** Reflection updates per second */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=MirrorBudget, meta=(ClampMin="1.0"))
+	float UpdateRate;
+
+	/** Level of detail distance multiplier used when rendering the reflection */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=MirrorBudget)
+	float LODDistanceFactor;
+
+	/** Furthest distance rendered in the reflection, 0 for no limit */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=MirrorBudget)
+	float MaxViewDistance;
+
+	/** Whether dynamic shadows are rendered in the reflection */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=MirrorBudget)
+	bool bCaptureDynamicShadows;
+
+	/** Counts for the current frame so far */
+	static const FVersatileMirrorFrameStats& GetCurrentFrameStats();
+
+	/** Counts for the last completed frame */
+	static const FVersatileMirrorFrameStats& GetLastFrameStats();
+
+	/** Total captures issued since startup */
+	static uint64 GetTotalCaptures();
+
+	virtual void PostInitializeComponents() override;
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void Tick(float DeltaSeconds) override;
+
+private:
+	/** Reflection render target, sized from the viewport and ResolutionScale */
+	UPROPERTY(Transient)
+	class UTextureRenderTarget2D* RenderTarget;
+
+	/** Instance of the mirror material that samples RenderTarget */
+	UPROPERTY(Transient)
+	class UMaterialInstanceDynamic* MirrorMaterial;
+
+	float TimeSinceCapture;
+
+	/** Frame this mirror was last considered for a capture on */
+	uint64 LastScheduledFrame;
+
+	/** Advances every mirror in this world and captures the due ones that fit the budget, longest waiting first */
+	void ScheduleCaptures(float DeltaSeconds);
+
+	/** Whether the mirror is on screen and facing the viewer */
+	bool IsVisibleFrom(const FVector& ViewLocation) const;
+
+	/** Resizes the render target when the viewport size or ResolutionScale changes */
+	void UpdateRenderTarget();
+
+	/** Positions the capture as the reflection of a view and renders it */
+	void CaptureReflection(const class APlayerCameraManager* CameraManager);
+
+};
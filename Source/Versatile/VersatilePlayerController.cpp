@@ -3,9 +3,348 @@
 #include "Versatile.h"
 #include "VersatilePlayerController.h"
 #include "VersatileCameraManager.h"
+#include "VersatileCharacter.h"
+#include "VersatileLightweightCharacter.h"
+#include "VersatileCharacterMovementComponent.h"
+#include "Serialization/MemoryWriter.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/ObjectAndNameAsStringProxyArchive.h"
 
 AVersatilePlayerController::AVersatilePlayerController()
 {
 	PlayerCameraManagerClass = AVersatileCameraManager::StaticClass();
+	
+	bPoolCameraRig = true;
+	bHasSavedCameraState = false;
+	FrameTimeMeasureRemaining = 0.f;
+	CameraCycleFrame = INDEX_NONE;
+	CameraCycleSwitches = 0;
+	CameraCycleFramesPerSwitch = 1;
+	CameraCycleWorstFrameMs = 0.f;
+	CameraCycleWorstSwitchFrameMs = 0.f;
+	CameraCycleTotalMs = 0.f;
+	
+	BenchmarkCharacterClass = AVersatileCharacter::StaticClass();
+	BenchmarkLightweightCharacterClass = AVersatileLightweightCharacter::StaticClass();
 }
 
+// MARK: - Camera Rig Pool
+
+bool AVersatilePlayerController::ClaimCameraRig(TSubclassOf<AVersatileCharacter> TemplateClass, FVersatileCameraRig& OutRig)
+{
+	if (!PooledCameraRig.IsComplete()) return false;
+	
+	// Meshes and camera tuning of another character class would carry over to this one
+	if (PooledCameraRig.TemplateClass != TemplateClass)
+	{
+		PooledCameraRig.DestroyComponents();
+		return false;
+	}
+	
+	OutRig = PooledCameraRig;
+	PooledCameraRig.Reset();
+	return true;
+}
+
+void AVersatilePlayerController::ParkCameraRig(const FVersatileCameraRig& Rig)
+{
+	if (PooledCameraRig.IsComplete())
+	{
+		PooledCameraRig.DestroyComponents();
+	}
+	PooledCameraRig = Rig;
+}
+
+// MARK: - Camera State
+
+void AVersatilePlayerController::SetSavedCameraState(const FVersatileCameraState& State)
+{
+	SavedCameraState = State;
+	bHasSavedCameraState = true;
+}
+
+FString AVersatilePlayerController::GetCameraStateFilename() const
+{
+	const ULocalPlayer* LocalPlayer = GetLocalPlayer();
+	const int32 ControllerId = LocalPlayer ? LocalPlayer->GetControllerId() : 0;
+	return FPaths::Combine(*FPaths::GameSavedDir(), *FString::Printf(TEXT("VersatileCameraState%d.bin"), ControllerId));
+}
+
+void AVersatilePlayerController::BeginPlay()
+{
+	Super::BeginPlay();
+	
+	// Controllers survive seamless travel with their state; anything else starts from the last session's file
+	if (!bHasSavedCameraState && IsLocalPlayerController())
+	{
+		TArray<uint8> Bytes;
+		if (FFileHelper::LoadFileToArray(Bytes, *GetCameraStateFilename(), FILEREAD_Silent))
+		{
+			bHasSavedCameraState = SavedCameraState.FromBytes(Bytes);
+		}
+	}
+}
+
+void AVersatilePlayerController::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	// Written before returning, since the game may be shutting down
+	if (IsLocalPlayerController())
+	{
+		CameraTelemetry.Flush(GetCameraTelemetryFilename(), false);
+	}
+	
+	if (bHasSavedCameraState && IsLocalPlayerController())
+	{
+		TArray<uint8> Bytes;
+		SavedCameraState.ToBytes(Bytes);
+		FFileHelper::SaveArrayToFile(Bytes, *GetCameraStateFilename());
+	}
+	
+	Super::EndPlay(EndPlayReason);
+}
+
+// MARK: - Camera Telemetry
+
+FVersatileCameraTelemetry* AVersatilePlayerController::GetCameraTelemetry()
+{
+	return (IsLocalPlayerController() && FVersatileCameraTelemetry::IsEnabled()) ? &CameraTelemetry : nullptr;
+}
+
+FString AVersatilePlayerController::GetCameraTelemetryFilename() const
+{
+	const ULocalPlayer* LocalPlayer = GetLocalPlayer();
+	const int32 ControllerId = LocalPlayer ? LocalPlayer->GetControllerId() : 0;
+	return FPaths::Combine(*FPaths::GameSavedDir(), *FString::Printf(TEXT("VersatileCameraTelemetry%d.bin"), ControllerId));
+}
+
+// MARK: - Benchmarks
+
+void AVersatilePlayerController::VersatileCameraStateBenchmark(int32 Iterations)
+{
+	if (Iterations <= 0) return;
+	
+	AVersatileCharacter* Character = Cast<AVersatileCharacter>(GetPawn());
+	const FVersatileCameraState Source = Character ? Character->GetCameraState() : FVersatileCameraState();
+	
+	// Binary record
+	TArray<uint8> RecordBytes;
+	FVersatileCameraState Restored;
+	double StartTime = FPlatformTime::Seconds();
+	for (int32 Index = 0; Index < Iterations; Index++)
+	{
+		Source.ToBytes(RecordBytes);
+		Restored.FromBytes(RecordBytes);
+	}
+	const double RecordMicroseconds = (FPlatformTime::Seconds() - StartTime) * 1000000.0 / Iterations;
+	
+	// USaveGame serialized through property reflection, the way save game slots are written
+	UVersatileCameraSaveGame* SaveGame = NewObject<UVersatileCameraSaveGame>();
+	SaveGame->CameraMode = Source.CameraMode;
+	SaveGame->CameraZoomCurrent = Source.CameraZoomCurrent;
+	SaveGame->CameraFollowTurnAngleExponent = Source.CameraFollowTurnAngleExponent;
+	SaveGame->CameraFollowTurnRate = Source.CameraFollowTurnRate;
+	SaveGame->CameraResetSpeed = Source.CameraResetSpeed;
+	SaveGame->AutoResetDelaySeconds = Source.AutoResetDelaySeconds;
+	SaveGame->AutoResetSpeed = Source.AutoResetSpeed;
+	SaveGame->bAutoResetSmoothFollowCameraWhenIdle = Source.bAutoResetSmoothFollowCameraWhenIdle;
+	
+	TArray<uint8> SaveGameBytes;
+	UVersatileCameraSaveGame* RestoredSaveGame = NewObject<UVersatileCameraSaveGame>();
+	StartTime = FPlatformTime::Seconds();
+	for (int32 Index = 0; Index < Iterations; Index++)
+	{
+		SaveGameBytes.Reset();
+		FMemoryWriter MemoryWriter(SaveGameBytes, true);
+		FObjectAndNameAsStringProxyArchive WriteAr(MemoryWriter, false);
+		SaveGame->Serialize(WriteAr);
+		
+		FMemoryReader MemoryReader(SaveGameBytes, true);
+		FObjectAndNameAsStringProxyArchive ReadAr(MemoryReader, true);
+		RestoredSaveGame->Serialize(ReadAr);
+	}
+	const double SaveGameMicroseconds = (FPlatformTime::Seconds() - StartTime) * 1000000.0 / Iterations;
+	
+	UE_LOG(LogVersatile, Log, TEXT("Camera state store+restore over %d iterations: binary record %.3f us (%d bytes), USaveGame %.3f us (%d bytes)"),
+		Iterations, RecordMicroseconds, RecordBytes.Num(), SaveGameMicroseconds, SaveGameBytes.Num());
+}
+
+void AVersatilePlayerController::VersatileSpawnBenchmark(int32 Count, bool bLightweight)
+{
+	UWorld* World = GetWorld();
+	UClass* SpawnClass = bLightweight ? *BenchmarkLightweightCharacterClass : *BenchmarkCharacterClass;
+	if (World == nullptr || SpawnClass == nullptr || Count <= 0) return;
+	
+	const FVector Origin = GetPawn() ? GetPawn()->GetActorLocation() : FVector::ZeroVector;
+	const int32 RowLength = FMath::CeilToInt(FMath::Sqrt((float)Count));
+	const float Spacing = 150.f;
+	
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	
+	const FPlatformMemoryStats MemoryBefore = FPlatformMemory::GetStats();
+	const double StartTime = FPlatformTime::Seconds();
+	
+	int32 ComponentCount = 0;
+	for (int32 Index = 0; Index < Count; Index++)
+	{
+		const FVector Location = Origin + FVector((Index / RowLength + 1) * Spacing, (Index % RowLength - RowLength / 2) * Spacing, 0.f);
+		AVersatileCharacter* Character = World->SpawnActor<AVersatileCharacter>(SpawnClass, Location, FRotator::ZeroRotator, SpawnParams);
+		if (Character != nullptr)
+		{
+			ComponentCount += Character->GetComponents().Num();
+			BenchmarkCharacters.Add(Character);
+		}
+	}
+	
+	const double ElapsedMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+	const FPlatformMemoryStats MemoryAfter = FPlatformMemory::GetStats();
+	const double MemoryDeltaMB = ((double)MemoryAfter.UsedPhysical - (double)MemoryBefore.UsedPhysical) / (1024.0 * 1024.0);
+	
+	UE_LOG(LogVersatile, Log, TEXT("Spawned %d x %s in %.2f ms (%.4f ms each), %d components, used physical memory delta %.2f MB (%.2f KB each)"),
+		Count, *SpawnClass->GetName(), ElapsedMs, ElapsedMs / Count, ComponentCount, MemoryDeltaMB, MemoryDeltaMB * 1024.0 / Count);
+}
+
+void AVersatilePlayerController::VersatileClearBenchmark()
+{
+	for (TWeakObjectPtr<AVersatileCharacter>& Character : BenchmarkCharacters)
+	{
+		if (Character.IsValid())
+		{
+			Character->Destroy();
+		}
+	}
+	BenchmarkCharacters.Empty();
+}
+
+void AVersatilePlayerController::VersatileMeasureFrameTime(float Seconds)
+{
+	MeasuredFrameTimes.Reset();
+	MeasuredFrameTimes.Reserve(FMath::CeilToInt(Seconds * 120.f));
+	FrameTimeMeasureRemaining = FMath::Max(Seconds, 0.f);
+	UE_LOG(LogVersatile, Log, TEXT("Measuring frame time for %.1f seconds"), FrameTimeMeasureRemaining);
+}
+
+void AVersatilePlayerController::VersatileNetStats()
+{
+	ACharacter* Character = Cast<ACharacter>(GetPawn());
+	UVersatileCharacterMovementComponent* Movement = Character ? Cast<UVersatileCharacterMovementComponent>(Character->GetCharacterMovement()) : nullptr;
+	if (Movement == nullptr) return;
+	
+	const UVersatileCharacterMovementComponent::FNetCounters& Counters = Movement->GetNetCounters();
+	const float CorrectionPercent = (Counters.MovesSent > 0) ? 100.f * Counters.Corrections / Counters.MovesSent : 0.f;
+	UE_LOG(LogVersatile, Log, TEXT("Movement: %u server moves sent (%u dual), %u corrections (%.2f%%), %u good move acks"),
+		Counters.MovesSent, Counters.DualMovesSent, Counters.Corrections, CorrectionPercent, Counters.GoodMoveAcks);
+	
+	Movement->ResetNetCounters();
+}
+
+void AVersatilePlayerController::VersatileCameraCycleBenchmark(int32 Switches, int32 FramesPerSwitch)
+{
+	if (Cast<AVersatileCharacter>(GetPawn()) == nullptr || Switches <= 0) return;
+	
+	CameraCycleFrame = 0;
+	CameraCycleSwitches = Switches;
+	CameraCycleFramesPerSwitch = FMath::Max(FramesPerSwitch, 1);
+	CameraCycleWorstFrameMs = 0.f;
+	CameraCycleWorstSwitchFrameMs = 0.f;
+	CameraCycleTotalMs = 0.f;
+}
+
+void AVersatilePlayerController::TickCameraCycleBenchmark()
+{
+	AVersatileCharacter* Character = Cast<AVersatileCharacter>(GetPawn());
+	if (Character == nullptr)
+	{
+		CameraCycleFrame = INDEX_NONE;
+		return;
+	}
+	
+	// A frame's delta is the duration of the previous frame, so a switch shows up one frame later
+	if (CameraCycleFrame > 0)
+	{
+		const float FrameMs = FApp::GetDeltaTime() * 1000.f;
+		CameraCycleTotalMs += FrameMs;
+		CameraCycleWorstFrameMs = FMath::Max(CameraCycleWorstFrameMs, FrameMs);
+		if ((CameraCycleFrame - 1) % CameraCycleFramesPerSwitch == 0)
+		{
+			CameraCycleWorstSwitchFrameMs = FMath::Max(CameraCycleWorstSwitchFrameMs, FrameMs);
+		}
+	}
+	
+	const int32 SwitchFrames = CameraCycleSwitches * CameraCycleFramesPerSwitch;
+	if (CameraCycleFrame < SwitchFrames)
+	{
+		if (CameraCycleFrame % CameraCycleFramesPerSwitch == 0)
+		{
+			Character->CycleCamera();
+		}
+		CameraCycleFrame++;
+		return;
+	}
+	
+	UE_LOG(LogVersatile, Log, TEXT("Camera cycling with prewarm %s: %d switches every %d frames, worst frame %.2f ms, worst switch frame %.2f ms, avg %.2f ms"),
+		Character->ShouldPrewarmNextCameraMode() ? TEXT("on") : TEXT("off"),
+		CameraCycleSwitches, CameraCycleFramesPerSwitch, CameraCycleWorstFrameMs, CameraCycleWorstSwitchFrameMs, CameraCycleTotalMs / SwitchFrames);
+	CameraCycleFrame = INDEX_NONE;
+}
+
+void AVersatilePlayerController::SetPawn(APawn* InPawn)
+{
+	AVersatileCharacter* OldCharacter = Cast<AVersatileCharacter>(GetPawn());
+	Super::SetPawn(InPawn);
+	
+	// Clients never call UnPossessed, so the rig a local player leaves behind is released here as well
+	if (OldCharacter != nullptr && OldCharacter != InPawn && IsLocalController() && !OldCharacter->IsPendingKillPending())
+	{
+		OldCharacter->ReleaseFromController(this);
+	}
+}
+
+void AVersatilePlayerController::UpdateHiddenComponents(const FVector& ViewLocation, TSet<FPrimitiveComponentId>& HiddenComponents)
+{
+	Super::UpdateHiddenComponents(ViewLocation, HiddenComponents);
+	
+	// Stands in for owner-no-see while the view target keeps its first person meshes warm
+	const AVersatileCharacter* Character = Cast<AVersatileCharacter>(GetViewTarget());
+	if (Character != nullptr)
+	{
+		Character->GetOwnerViewHiddenComponents(HiddenComponents);
+	}
+}
+
+void AVersatilePlayerController::PlayerTick(float DeltaTime)
+{
+	Super::PlayerTick(DeltaTime);
+	
+	if (GetCameraTelemetry() != nullptr && CameraTelemetry.Tick(DeltaTime))
+	{
+		CameraTelemetry.Flush(GetCameraTelemetryFilename());
+	}
+	
+	if (CameraCycleFrame != INDEX_NONE)
+	{
+		TickCameraCycleBenchmark();
+	}
+	
+	if (FrameTimeMeasureRemaining <= 0.f) return;
+	
+	// Use the real frame time rather than the dilated game delta
+	MeasuredFrameTimes.Add(FApp::GetDeltaTime() * 1000.f);
+	FrameTimeMeasureRemaining -= DeltaTime;
+	if (FrameTimeMeasureRemaining > 0.f || MeasuredFrameTimes.Num() == 0) return;
+	
+	FrameTimeMeasureRemaining = 0.f;
+	MeasuredFrameTimes.Sort();
+	
+	float Total = 0.f;
+	for (float FrameTime : MeasuredFrameTimes)
+	{
+		Total += FrameTime;
+	}
+	
+	const int32 Count = MeasuredFrameTimes.Num();
+	auto Percentile = [this, Count](float Fraction) { return MeasuredFrameTimes[FMath::Clamp(FMath::FloorToInt(Fraction * Count), 0, Count - 1)]; };
+	
+	UE_LOG(LogVersatile, Log, TEXT("Frame time over %d frames: avg %.2f ms, p50 %.2f ms, p95 %.2f ms, p99 %.2f ms, max %.2f ms"),
+		Count, Total / Count, Percentile(.5f), Percentile(.95f), Percentile(.99f), MeasuredFrameTimes.Last());
+}
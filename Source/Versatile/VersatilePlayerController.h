@@ -3,6 +3,8 @@
 #pragma once
 
 #include "GameFramework/PlayerController.h"
+#include "VersatileCharacter.h"
+#include "VersatileCameraTelemetry.h"
 #include "VersatilePlayerController.generated.h"
 
 /**
@@ -14,6 +16,147 @@ class VERSATILE_API AVersatilePlayerController : public APlayerController
 	GENERATED_BODY()
 	AVersatilePlayerController();
 	
+public:
+	/**
+	 * Whether camera rigs created on demand by lightweight characters are kept on this controller when
+	 * it unpossesses them and handed to the next lightweight character it possesses.
+	 */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category=Camera)
+	bool bPoolCameraRig;
 	
+	/**
+	 * Takes the parked camera rig, if there is one built from the same template class.
+	 * A rig built from another class is destroyed rather than handed over.
+	 * @param TemplateClass	ViewComponentTemplateClass of the character claiming the rig
+	 * @param OutRig		Receives the rig; the controller no longer references it afterwards
+	 * @return Whether a complete, matching rig was available
+	 */
+	bool ClaimCameraRig(TSubclassOf<AVersatileCharacter> TemplateClass, FVersatileCameraRig& OutRig);
+	
+	/**
+	 * Parks a camera rig on this controller until the next possession. Any rig already parked is destroyed.
+	 * @param Rig	A rig whose components are already owned by this controller
+	 */
+	void ParkCameraRig(const FVersatileCameraRig& Rig);
+	
+	/** Whether a camera state has been saved for this player */
+	bool HasSavedCameraState() const { return bHasSavedCameraState; }
+	
+	/** The camera state last saved for this player */
+	const FVersatileCameraState& GetSavedCameraState() const { return SavedCameraState; }
+	
+	/**
+	 * Saves the player's camera state for their next pawn. Written to disk when this controller ends play,
+	 * so it also survives reconnecting and restarting.
+	 * @param State	The state to save
+	 */
+	void SetSavedCameraState(const FVersatileCameraState& State);
+	
+	/** Camera behaviour telemetry for this player, or nullptr when not recording */
+	FVersatileCameraTelemetry* GetCameraTelemetry();
+	
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	
+	/**
+	 * Times storing and restoring the camera state as a binary record against USaveGame property serialization.
+	 * @param Iterations	Number of store and restore round trips to time for each
+	 */
+	UFUNCTION(exec)
+	void VersatileCameraStateBenchmark(int32 Iterations);
+	
+	/** Character class spawned by VersatileSpawnBenchmark when bLightweight is false */
+	UPROPERTY(EditDefaultsOnly, Category=Benchmark)
+	TSubclassOf<AVersatileCharacter> BenchmarkCharacterClass;
+	
+	/** Character class spawned by VersatileSpawnBenchmark when bLightweight is true */
+	UPROPERTY(EditDefaultsOnly, Category=Benchmark)
+	TSubclassOf<AVersatileCharacter> BenchmarkLightweightCharacterClass;
+	
+	/**
+	 * Spawns unpossessed background characters in a grid and logs spawn time, memory and component counts.
+	 * @param Count			Number of characters to spawn
+	 * @param bLightweight	Whether to spawn the lightweight (camera-less) character variant
+	 */
+	UFUNCTION(exec)
+	void VersatileSpawnBenchmark(int32 Count, bool bLightweight);
+	
+	/** Destroys every character spawned by VersatileSpawnBenchmark */
+	UFUNCTION(exec)
+	void VersatileClearBenchmark();
+	
+	/**
+	 * Records frame times for a while and logs the average and percentiles, e.g. to compare a crowd
+	 * with versatile.Significance 0 and 1.
+	 * @param Seconds	How long to record for
+	 */
+	UFUNCTION(exec)
+	void VersatileMeasureFrameTime(float Seconds);
+	
+	/**
+	 * Logs the server moves sent, corrections and acknowledgements counted by the pawn's movement
+	 * since the last call, then resets them. Pair with Net PktLag to compare correction rates.
+	 */
+	UFUNCTION(exec)
+	void VersatileNetStats();
+	
+	/**
+	 * Cycles the pawn's camera mode rapidly and logs the worst frame time, e.g. to compare
+	 * versatile.CameraPrewarm 0 and 1.
+	 * @param Switches			Number of camera mode switches
+	 * @param FramesPerSwitch	Frames between switches; the next mode is prepared in the frames between, so use at least 2
+	 */
+	UFUNCTION(exec)
+	void VersatileCameraCycleBenchmark(int32 Switches, int32 FramesPerSwitch);
+	
+	/** Whether VersatileCameraCycleBenchmark is still cycling */
+	bool IsCameraCycleBenchmarkRunning() const { return CameraCycleFrame != INDEX_NONE; }
+	
+	/** Frame times in milliseconds from the last VersatileCameraCycleBenchmark run */
+	float GetCameraCycleWorstFrameMs() const { return CameraCycleWorstFrameMs; }
+	float GetCameraCycleWorstSwitchFrameMs() const { return CameraCycleWorstSwitchFrameMs; }
+	float GetCameraCycleAverageFrameMs() const { return CameraCycleTotalMs / FMath::Max(CameraCycleSwitches * CameraCycleFramesPerSwitch, 1); }
+	
+	virtual void SetPawn(APawn* InPawn) override;
+	virtual void UpdateHiddenComponents(const FVector& ViewLocation, TSet<FPrimitiveComponentId>& HiddenComponents) override;
+	virtual void PlayerTick(float DeltaTime) override;
+	
+private:
+	/** Camera rig left behind by the last lightweight character this controller possessed */
+	UPROPERTY(Transient)
+	FVersatileCameraRig PooledCameraRig;
+	
+	/** Camera state carried between this player's pawns */
+	FVersatileCameraState SavedCameraState;
+	bool bHasSavedCameraState;
+	
+	/** File the camera state is kept in between sessions */
+	FString GetCameraStateFilename() const;
+	
+	/** Camera behaviour histograms for this player */
+	FVersatileCameraTelemetry CameraTelemetry;
+	
+	/** File camera telemetry intervals are appended to */
+	FString GetCameraTelemetryFilename() const;
+	
+	/** Characters spawned by VersatileSpawnBenchmark */
+	TArray<TWeakObjectPtr<AVersatileCharacter>> BenchmarkCharacters;
+	
+	/** Frame times in milliseconds recorded by VersatileMeasureFrameTime */
+	TArray<float> MeasuredFrameTimes;
+	
+	/** Seconds of frame time recording left, or zero when not recording */
+	float FrameTimeMeasureRemaining;
+	
+	/** Progress of VersatileCameraCycleBenchmark, with CameraCycleFrame at INDEX_NONE when not running */
+	int32 CameraCycleFrame;
+	int32 CameraCycleSwitches;
+	int32 CameraCycleFramesPerSwitch;
+	float CameraCycleWorstFrameMs;
+	float CameraCycleWorstSwitchFrameMs;
+	float CameraCycleTotalMs;
+	
+	/** Switches the camera mode and records frame times for VersatileCameraCycleBenchmark */
+	void TickCameraCycleBenchmark();
 	
 };
@@ -0,0 +1,374 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Versatile.h"
+#include "VersatileSignificanceManager.h"
+#include "VersatileCharacter.h"
+#include "Engine.h"
+
+DECLARE_CYCLE_STAT(TEXT("Significance Tick"), STAT_VersatileSignificanceTick, STATGROUP_Versatile);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Significance Characters Scored"), STAT_VersatileSignificanceScored, STATGROUP_Versatile);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Significance Tier Viewed"), STAT_VersatileSignificanceViewed, STATGROUP_Versatile);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Significance Tier Near"), STAT_VersatileSignificanceNear, STATGROUP_Versatile);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Significance Tier Mid"), STAT_VersatileSignificanceMid, STATGROUP_Versatile);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Significance Tier Far"), STAT_VersatileSignificanceFar, STATGROUP_Versatile);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Significance Tier Hidden"), STAT_VersatileSignificanceHidden, STATGROUP_Versatile);
+
+static TAutoConsoleVariable<int32> CVarVersatileSignificance(
+	TEXT("versatile.Significance"),
+	1,
+	TEXT("Whether Versatile characters have tick, animation, shadow and LOD settings scaled by significance.\n")
+	TEXT(" 0: all characters at full detail\n")
+	TEXT(" 1: scale by significance tier (default)"),
+	ECVF_Default);
+
+//////////////////////////////////////////////////////////////////////////
+// FVersatileSignificanceTierSettings
+
+FVersatileSignificanceTierSettings::FVersatileSignificanceTierSettings()
+	: MaxDistance(0.f)
+	, MaxCharacters(0)
+	, ActorTickInterval(0.f)
+	, AnimationTickInterval(0.f)
+	, bOnlyTickPoseWhenRendered(false)
+	, bCastShadow(true)
+	, MinLOD(0)
+{
+}
+
+FVersatileSignificanceTierSettings::FVersatileSignificanceTierSettings(float InMaxDistance, int32 InMaxCharacters, float InActorTickInterval, float InAnimationTickInterval, bool bInOnlyTickPoseWhenRendered, bool bInCastShadow, int32 InMinLOD)
+	: MaxDistance(InMaxDistance)
+	, MaxCharacters(InMaxCharacters)
+	, ActorTickInterval(InActorTickInterval)
+	, AnimationTickInterval(InAnimationTickInterval)
+	, bOnlyTickPoseWhenRendered(bInOnlyTickPoseWhenRendered)
+	, bCastShadow(bInCastShadow)
+	, MinLOD(InMinLOD)
+{
+}
+
+//////////////////////////////////////////////////////////////////////////
+// AVersatileSignificanceManager
+
+AVersatileSignificanceManager::AVersatileSignificanceManager()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bTickEvenWhenPaused = false;
+
+	// Ranking uses camera locations, so run after cameras have been updated for the frame
+	PrimaryActorTick.TickGroup = TG_PostUpdateWork;
+
+	TierSettings.SetNum(EVersatileSignificanceTier::Max);
+	//																					Distance	Max	Tick	Anim	OnlyRendered	Shadow	MinLOD
+	TierSettings[EVersatileSignificanceTier::Viewed]	= FVersatileSignificanceTierSettings(0.f,		0,	0.f,	0.f,	false,			true,	0);
+	TierSettings[EVersatileSignificanceTier::Near]		= FVersatileSignificanceTierSettings(1500.f,	16,	0.f,	0.f,	false,			true,	0);
+	TierSettings[EVersatileSignificanceTier::Mid]		= FVersatileSignificanceTierSettings(4000.f,	64,	.1f,	1.f/30.f, false,		true,	1);
+	TierSettings[EVersatileSignificanceTier::Far]		= FVersatileSignificanceTierSettings(0.f,		0,	.25f,	1.f/15.f, true,			false,	2);
+	TierSettings[EVersatileSignificanceTier::Hidden]	= FVersatileSignificanceTierSettings(0.f,		0,	.5f,	.25f,	true,			false,	2);
+
+	EvaluationBudgetMs = .1f;
+	RankIntervalSeconds = .25f;
+	RecentlyRenderedTolerance = .2f;
+
+	NextScoreIndex = 0;
+	TimeSinceRank = 0.f;
+	FMemory::Memzero(TierCounts, sizeof(TierCounts));
+	bTiersApplied = false;
+}
+
+AVersatileSignificanceManager* AVersatileSignificanceManager::Find(UWorld* World)
+{
+	if (World == nullptr) return nullptr;
+
+	for (TActorIterator<AVersatileSignificanceManager> It(World); It; ++It)
+	{
+		if (!It->IsPendingKill())
+		{
+			return *It;
+		}
+	}
+	return nullptr;
+}
+
+AVersatileSignificanceManager* AVersatileSignificanceManager::Get(UWorld* World)
+{
+	// Nothing is rendered on a dedicated server, and thinning server animation would affect gameplay.
+	// Listen servers keep characters they simulate for others at full detail; see NeedsServerPose.
+	if (World == nullptr || !World->IsGameWorld() || World->GetNetMode() == NM_DedicatedServer) return nullptr;
+
+	AVersatileSignificanceManager* Manager = Find(World);
+	if (Manager == nullptr)
+	{
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.ObjectFlags |= RF_Transient;
+		Manager = World->SpawnActor<AVersatileSignificanceManager>(SpawnParams);
+	}
+	return Manager;
+}
+
+void AVersatileSignificanceManager::RegisterCharacter(AVersatileCharacter* Character)
+{
+	if (Character == nullptr || Character->GetMesh() == nullptr) return;
+
+	for (const FEntry& Existing : Entries)
+	{
+		if (Existing.Character == Character) return;
+	}
+
+	USkeletalMeshComponent* Mesh = Character->GetMesh();
+
+	FEntry Entry;
+	Entry.Character = Character;
+	Entry.DistanceSquared = 0.f;
+	Entry.bRecentlyRendered = true;
+	Entry.Tier = EVersatileSignificanceTier::Viewed;
+	Entry.BaseActorTickInterval = Character->GetActorTickInterval();
+	Entry.BaseMeshTickInterval = Mesh->GetComponentTickInterval();
+	Entry.BaseMeshUpdateFlag = Mesh->MeshComponentUpdateFlag;
+	Entry.bBaseCastShadow = Mesh->CastShadow;
+	Entry.bBaseCastDynamicShadow = Mesh->bCastDynamicShadow;
+	Entry.bBaseCastHiddenShadow = Mesh->bCastHiddenShadow;
+	Entry.BaseMinLOD = Mesh->MinLodModel;
+	Entries.Add(Entry);
+}
+
+void AVersatileSignificanceManager::UnregisterCharacter(AVersatileCharacter* Character)
+{
+	for (int32 Index = 0; Index < Entries.Num(); Index++)
+	{
+		if (Entries[Index].Character == Character)
+		{
+			ApplyTier(Entries[Index], EVersatileSignificanceTier::Viewed);
+			Entries.RemoveAtSwap(Index);
+			return;
+		}
+	}
+}
+
+EVersatileSignificanceTier::Type AVersatileSignificanceManager::GetTier(const AVersatileCharacter* Character) const
+{
+	for (const FEntry& Entry : Entries)
+	{
+		if (Entry.Character == Character)
+		{
+			return Entry.Tier;
+		}
+	}
+	return EVersatileSignificanceTier::Viewed;
+}
+
+void AVersatileSignificanceManager::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	RestoreAll();
+	Entries.Empty();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+// MARK: - Tick
+
+void AVersatileSignificanceManager::Tick(float DeltaSeconds)
+{
+	SCOPE_CYCLE_COUNTER(STAT_VersatileSignificanceTick);
+	Super::Tick(DeltaSeconds);
+
+	if (CVarVersatileSignificance.GetValueOnGameThread() == 0)
+	{
+		RestoreAll();
+		return;
+	}
+
+	GatherViewers();
+	if (Entries.Num() == 0) return;
+
+	// Score characters round robin until this frame's budget is spent
+	const double Deadline = FPlatformTime::Seconds() + EvaluationBudgetMs / 1000.0;
+	int32 Scored = 0;
+	while (Scored < Entries.Num())
+	{
+		if (NextScoreIndex >= Entries.Num())
+		{
+			NextScoreIndex = 0;
+		}
+		ScoreEntry(Entries[NextScoreIndex]);
+		NextScoreIndex++;
+		Scored++;
+
+		// Checking the clock costs about as much as scoring, so only do it every few entries
+		if ((Scored & 15) == 0 && FPlatformTime::Seconds() > Deadline)
+		{
+			break;
+		}
+	}
+	SET_DWORD_STAT(STAT_VersatileSignificanceScored, Scored);
+
+	TimeSinceRank += DeltaSeconds;
+	if (TimeSinceRank >= RankIntervalSeconds || !bTiersApplied)
+	{
+		TimeSinceRank = 0.f;
+		RankAndApply();
+	}
+}
+
+void AVersatileSignificanceManager::GatherViewers()
+{
+	ViewLocations.Reset();
+	ViewedActors.Reset();
+
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		APlayerController* PlayerController = *It;
+		if (PlayerController == nullptr || !PlayerController->IsLocalController()) continue;
+
+		if (PlayerController->PlayerCameraManager != nullptr)
+		{
+			ViewLocations.Add(PlayerController->PlayerCameraManager->GetCameraLocation());
+		}
+		ViewedActors.Add(PlayerController->GetViewTarget());
+		ViewedActors.Add(PlayerController->GetPawn());
+	}
+}
+
+bool AVersatileSignificanceManager::NeedsServerPose(const AVersatileCharacter* Character) const
+{
+	// A listen server simulates remote players' pawns for everyone, and hit detection reads their bones.
+	// Pawns with no controller or an AI one are only background, so they are scaled like any other
+	if (Character == nullptr || GetNetMode() != NM_ListenServer || !Character->HasAuthority()) return false;
+
+	const APlayerController* PlayerController = Cast<APlayerController>(Character->GetController());
+	return PlayerController != nullptr && !PlayerController->IsLocalController();
+}
+
+void AVersatileSignificanceManager::ScoreEntry(FEntry& Entry) const
+{
+	AVersatileCharacter* Character = Entry.Character.Get();
+	if (Character == nullptr) return;
+
+	const FVector Location = Character->GetActorLocation();
+	float ClosestSquared = MAX_FLT;
+	for (const FVector& ViewLocation : ViewLocations)
+	{
+		ClosestSquared = FMath::Min(ClosestSquared, FVector::DistSquared(Location, ViewLocation));
+	}
+
+	Entry.DistanceSquared = ClosestSquared;
+	Entry.bRecentlyRendered = Character->WasRecentlyRendered(RecentlyRenderedTolerance);
+}
+
+void AVersatileSignificanceManager::RankAndApply()
+{
+	Entries.RemoveAllSwap([](const FEntry& Entry) { return !Entry.Character.IsValid(); });
+
+	// Most significant first
+	TArray<int32> Order;
+	Order.Reserve(Entries.Num());
+	for (int32 Index = 0; Index < Entries.Num(); Index++)
+	{
+		Order.Add(Index);
+	}
+	Order.Sort([this](int32 A, int32 B) { return Entries[A].DistanceSquared < Entries[B].DistanceSquared; });
+
+	FMemory::Memzero(TierCounts, sizeof(TierCounts));
+	for (int32 Index : Order)
+	{
+		FEntry& Entry = Entries[Index];
+
+		// Viewing is checked every rank rather than when scored so possession changes apply promptly
+		EVersatileSignificanceTier::Type Tier;
+		if (ViewedActors.Contains(Entry.Character.Get()) || NeedsServerPose(Entry.Character.Get()))
+		{
+			Tier = EVersatileSignificanceTier::Viewed;
+		}
+		else if (!Entry.bRecentlyRendered)
+		{
+			Tier = EVersatileSignificanceTier::Hidden;
+		}
+		else
+		{
+			Tier = EVersatileSignificanceTier::Far;
+			for (int32 Candidate = EVersatileSignificanceTier::Near; Candidate < EVersatileSignificanceTier::Far; Candidate++)
+			{
+				const FVersatileSignificanceTierSettings& Settings = TierSettings[Candidate];
+				const bool bInRange = Entry.DistanceSquared <= FMath::Square(Settings.MaxDistance);
+				const bool bHasRoom = Settings.MaxCharacters <= 0 || TierCounts[Candidate] < Settings.MaxCharacters;
+				if (bInRange && bHasRoom)
+				{
+					Tier = (EVersatileSignificanceTier::Type)Candidate;
+					break;
+				}
+			}
+		}
+
+		TierCounts[Tier]++;
+		if (Tier != Entry.Tier || !bTiersApplied)
+		{
+			ApplyTier(Entry, Tier);
+		}
+	}
+	bTiersApplied = true;
+
+	SET_DWORD_STAT(STAT_VersatileSignificanceViewed, TierCounts[EVersatileSignificanceTier::Viewed]);
+	SET_DWORD_STAT(STAT_VersatileSignificanceNear, TierCounts[EVersatileSignificanceTier::Near]);
+	SET_DWORD_STAT(STAT_VersatileSignificanceMid, TierCounts[EVersatileSignificanceTier::Mid]);
+	SET_DWORD_STAT(STAT_VersatileSignificanceFar, TierCounts[EVersatileSignificanceTier::Far]);
+	SET_DWORD_STAT(STAT_VersatileSignificanceHidden, TierCounts[EVersatileSignificanceTier::Hidden]);
+}
+
+void AVersatileSignificanceManager::ApplyTier(FEntry& Entry, EVersatileSignificanceTier::Type Tier) const
+{
+	Entry.Tier = Tier;
+
+	AVersatileCharacter* Character = Entry.Character.Get();
+	if (Character == nullptr || Character->GetMesh() == nullptr || !TierSettings.IsValidIndex(Tier)) return;
+
+	USkeletalMeshComponent* Mesh = Character->GetMesh();
+	const bool bViewed = (Tier == EVersatileSignificanceTier::Viewed);
+
+	// The viewed character always gets exactly what it was spawned with
+	FVersatileSignificanceTierSettings Settings = TierSettings[Tier];
+	if (bViewed)
+	{
+		Settings = FVersatileSignificanceTierSettings();
+	}
+
+	Character->SetActorTickInterval(FMath::Max(Entry.BaseActorTickInterval, Settings.ActorTickInterval));
+	Mesh->SetComponentTickInterval(FMath::Max(Entry.BaseMeshTickInterval, Settings.AnimationTickInterval));
+	// Update flags are ordered from most to least work, so the larger of the two is the less detailed
+	Mesh->MeshComponentUpdateFlag = Settings.bOnlyTickPoseWhenRendered ? FMath::Max<EMeshComponentUpdateFlag::Type>(Entry.BaseMeshUpdateFlag, EMeshComponentUpdateFlag::OnlyTickPoseWhenRendered) : Entry.BaseMeshUpdateFlag.GetValue();
+	Mesh->MinLodModel = FMath::Max(Entry.BaseMinLOD, Settings.MinLOD);
+
+	// Hidden shadows only matter for the character a player is looking out of in first person
+	const bool bCastShadow = Entry.bBaseCastShadow && Settings.bCastShadow;
+	const bool bCastDynamicShadow = Entry.bBaseCastDynamicShadow && Settings.bCastShadow;
+	const bool bCastHiddenShadow = Entry.bBaseCastHiddenShadow && bViewed;
+	if (Mesh->CastShadow != bCastShadow || Mesh->bCastDynamicShadow != bCastDynamicShadow || Mesh->bCastHiddenShadow != bCastHiddenShadow)
+	{
+		Mesh->CastShadow = bCastShadow;
+		Mesh->bCastDynamicShadow = bCastDynamicShadow;
+		Mesh->bCastHiddenShadow = bCastHiddenShadow;
+		Mesh->MarkRenderStateDirty();
+	}
+
+	// First person meshes are only ever visible to the viewing player, so nobody else needs them animated
+	if (Character->GetArmsMesh() != nullptr)
+	{
+		Character->GetArmsMesh()->SetComponentTickEnabled(bViewed);
+	}
+	if (Character->GetBodyMesh() != nullptr)
+	{
+		Character->GetBodyMesh()->SetComponentTickEnabled(bViewed);
+	}
+}
+
+void AVersatileSignificanceManager::RestoreAll()
+{
+	if (!bTiersApplied) return;
+
+	for (FEntry& Entry : Entries)
+	{
+		ApplyTier(Entry, EVersatileSignificanceTier::Viewed);
+	}
+	bTiersApplied = false;
+
+	FMemory::Memzero(TierCounts, sizeof(TierCounts));
+	TierCounts[EVersatileSignificanceTier::Viewed] = Entries.Num();
+}
@@ -0,0 +1,170 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "GameFramework/Actor.h"
+#include "VersatileSignificanceManager.generated.h"
+
+class AVersatileCharacter;
+
+// MARK: - Significance Tier Enumeration
+
+UENUM(BlueprintType)
+namespace EVersatileSignificanceTier
+{
+	enum	Type
+	{
+		Viewed			UMETA(DisplayName="Viewed by a Local Player"),
+		Near			UMETA(DisplayName="Near"),
+		Mid				UMETA(DisplayName="Mid"),
+		Far				UMETA(DisplayName="Far"),
+		Hidden			UMETA(DisplayName="Not Recently Rendered"),
+
+		Max				UMETA(Hidden),
+	};
+}
+
+// MARK: - Tier Settings
+
+/**
+ * Detail settings applied to every character in a significance tier.
+ * Settings only ever reduce detail below what the character was spawned with.
+ */
+USTRUCT(BlueprintType)
+struct FVersatileSignificanceTierSettings
+{
+	GENERATED_BODY()
+
+	/** Furthest distance from the nearest viewer for this tier. Only used by Near, Mid and Far */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=Significance)
+	float MaxDistance;
+
+	/** Most characters allowed in this tier; the rest drop to the next tier. 0 means no limit */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=Significance)
+	int32 MaxCharacters;
+
+	/** Actor tick interval, which is also how often camera logic runs */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=Significance)
+	float ActorTickInterval;
+
+	/** Tick interval of the third person mesh, which drives the animation update rate */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=Significance)
+	float AnimationTickInterval;
+
+	/** Whether the third person mesh only ticks its pose while rendered */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=Significance)
+	bool bOnlyTickPoseWhenRendered;
+
+	/** Whether the third person mesh casts shadows */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=Significance)
+	bool bCastShadow;
+
+	/** Lowest (most detailed) skeletal LOD the third person mesh may use */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=Significance)
+	int32 MinLOD;
+
+	FVersatileSignificanceTierSettings();
+	FVersatileSignificanceTierSettings(float InMaxDistance, int32 InMaxCharacters, float InActorTickInterval, float InAnimationTickInterval, bool bInOnlyTickPoseWhenRendered, bool bInCastShadow, int32 InMinLOD);
+};
+
+// MARK: - AVersatileSignificanceManager
+
+/**
+ * Ranks every Versatile character in the world by whether a local player views it, whether it was
+ * recently rendered and its distance to the nearest local viewer, then scales its tick, animation,
+ * shadow and LOD settings by tier. Scoring is time-sliced under EvaluationBudgetMs per frame.
+ * One is spawned on demand per game world; dedicated servers do not use one, and on a listen server
+ * pawns of remote players are kept at full detail (in the Viewed tier).
+ */
+UCLASS(config=Game, notplaceable, transient)
+class VERSATILE_API AVersatileSignificanceManager : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	AVersatileSignificanceManager();
+
+	/** Settings for each tier, indexed by EVersatileSignificanceTier */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=Significance)
+	TArray<FVersatileSignificanceTierSettings> TierSettings;
+
+	/** CPU time in milliseconds spent scoring characters each frame */
+	UPROPERTY(config, EditAnywhere, BlueprintReadWrite, Category=Significance)
+	float EvaluationBudgetMs;
+
+	/** Seconds between re-ranking characters into tiers */
+	UPROPERTY(config, EditAnywhere, BlueprintReadWrite, Category=Significance)
+	float RankIntervalSeconds;
+
+	/** Seconds since last render after which a character counts as not visible */
+	UPROPERTY(config, EditAnywhere, BlueprintReadWrite, Category=Significance)
+	float RecentlyRenderedTolerance;
+
+	/** Finds the manager for a world, spawning one if needed. Returns nullptr where none is wanted */
+	static AVersatileSignificanceManager* Get(UWorld* World);
+
+	/** Finds the manager for a world without spawning one */
+	static AVersatileSignificanceManager* Find(UWorld* World);
+
+	/** Starts managing a character, recording its current settings as its full detail baseline */
+	void RegisterCharacter(AVersatileCharacter* Character);
+
+	/** Stops managing a character and restores its baseline settings */
+	void UnregisterCharacter(AVersatileCharacter* Character);
+
+	/** Returns the tier a character is currently in, Viewed if it is not managed */
+	EVersatileSignificanceTier::Type GetTier(const AVersatileCharacter* Character) const;
+
+	/** Returns how many characters were put in a tier at the last ranking */
+	int32 GetTierCount(EVersatileSignificanceTier::Type Tier) const { return (Tier < EVersatileSignificanceTier::Max) ? TierCounts[Tier] : 0; }
+
+	virtual void Tick(float DeltaSeconds) override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	/** A managed character and the settings it had when registered */
+	struct FEntry
+	{
+		TWeakObjectPtr<AVersatileCharacter> Character;
+
+		/** Squared distance to the nearest viewer when last scored */
+		float DistanceSquared;
+		bool bRecentlyRendered;
+		EVersatileSignificanceTier::Type Tier;
+
+		float BaseActorTickInterval;
+		float BaseMeshTickInterval;
+		TEnumAsByte<EMeshComponentUpdateFlag::Type> BaseMeshUpdateFlag;
+		bool bBaseCastShadow;
+		bool bBaseCastDynamicShadow;
+		bool bBaseCastHiddenShadow;
+		int32 BaseMinLOD;
+	};
+
+	TArray<FEntry> Entries;
+
+	/** Camera locations and view targets of local players, refreshed every tick */
+	TArray<FVector> ViewLocations;
+	TArray<AActor*> ViewedActors;
+
+	/** Next entry to score; scoring resumes here when the budget runs out */
+	int32 NextScoreIndex;
+
+	float TimeSinceRank;
+
+	/** Characters in each tier at the last ranking */
+	int32 TierCounts[EVersatileSignificanceTier::Max];
+
+	/** Whether characters currently have tier settings applied */
+	bool bTiersApplied;
+
+	void GatherViewers();
+	/** Whether a character's server-side pose matters to others, so it must stay at full detail */
+	bool NeedsServerPose(const AVersatileCharacter* Character) const;
+
+	void ScoreEntry(FEntry& Entry) const;
+	void RankAndApply();
+	void ApplyTier(FEntry& Entry, EVersatileSignificanceTier::Type Tier) const;
+	void RestoreAll();
+
+};